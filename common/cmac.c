@@ -33,11 +33,94 @@
 
 #include <string.h>
 #include "config.h"
+#include <avr/pgmspace.h>
 #include "xtea.h"
 #include "wireless.h"
+#include "cmac.h"
 
 #if RFM
 
+static const uint8_t Km_upper[8] PROGMEM = {
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
+};
+
+#if defined(__AVR__)
+/* internal function for cmac_init */
+/* use loop inside - short/slow */
+asm (
+	"left_roll:               \n"
+	"   ldd r26,Y+7           \n"
+	"   lsl r26               \n"
+	"   in r27,__SREG__       \n"   // save carry
+	"   ldi r26,7             \n"   // 8 times
+	"roll_loop:               \n"
+	"   ld __tmp_reg__,Y      \n"
+	"   out __SREG__,r27      \n"   // restore carry
+	"   rol __tmp_reg__       \n"
+	"   in r27,__SREG__       \n"   // save carry
+	"   st Z,__tmp_reg__      \n"
+	"   adiw r28,1            \n"   // Y++
+	"   adiw r30,1            \n"   // Z++
+	"   subi r26,1            \n"
+	"   brcc roll_loop        \n"   // 8 times loop
+	"   sbiw r28,8            \n"   // Y-=8
+	"   ret "
+);
+#else
+/* host build: same as left_roll above, 64 bit rotate of little endian block */
+static void left_roll(uint8_t *d, const uint8_t *s)
+{
+	uint8_t c = s[7] >> 7;
+	uint8_t i;
+
+	for (i = 0; i < 8; i++)
+	{
+		uint8_t t = s[i];
+		d[i] = (t << 1) | c;
+		c = t >> 7;
+	}
+}
+#endif
+
+/*!
+ *******************************************************************************
+ *  generate K_mac, K_enc, K1 and K2 from security key
+ *  \note K_m shares space with K1 & K2, see wireless.h
+ ******************************************************************************/
+void cmac_init(const uint8_t *security_key)
+{
+	uint8_t i;
+
+	memcpy(K_m, security_key, 8);
+	memcpy_P(K_m + 8, Km_upper, sizeof(Km_upper));
+	for (i = 0; i < 3 * 8; i++)
+	{
+		Keys[i] = 0xc0 + i;
+	}
+	xtea_enc(K_mac, K_mac, K_m);            /* generate K_mac low 8 bytes */
+	xtea_enc(K_enc, K_enc, K_m);            /* generate K_mac high 8 bytes  and K_enc low 8 bytes*/
+	xtea_enc(K_enc + 8, K_enc + 8, K_m);    /* generate K_enc high 8 bytes */
+	for (i = 0; i < 8; i++)                 // smaller&faster than memset
+	{
+		K1[i] = 0;
+	}
+	xtea_enc(K1, K1, K_mac);
+#if defined(__AVR__)
+	asm (
+		"   movw  R30,%A0   \n"
+		"   rcall left_roll \n" /* generate K1 */
+		"   ldi r30,lo8(" STR(K2) ") \n"
+		"   ldi r31,hi8(" STR(K2) ") \n"
+		"   rcall left_roll \n" /* generate K2 */
+		:: "y" (K1)
+		: "r26", "r27", "r30", "r31"
+	);
+#else
+	left_roll(K1, K1);
+	left_roll(K2, K1);
+#endif
+}
+
 bool cmac_calc(uint8_t *m, uint8_t bytes, uint8_t *data_prefix, bool check)
 {
 /*   reference: http://csrc.nist.gov/publications/nistpubs/800-38B/SP_800-38B.pdf
@@ -76,11 +159,7 @@ bool cmac_calc(uint8_t *m, uint8_t bytes, uint8_t *data_prefix, bool check)
 	{
 		uint8_t x = i;
 		i += 8;
-// Ignore maybe ununitialized for Kx, since it is filled (line 77) before being used (line 82)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-		uint8_t *Kx;
-#pragma GCC diagnostic pop
+		const uint8_t *Kx = K1; // only used on last block, initialized to keep compiler quiet
 		if (i >= bytes)
 		{
 			Kx = ((i == bytes) ? K1 : K2);
@@ -31,4 +31,5 @@
  * $Rev$
  */
 
+void cmac_init(const uint8_t *security_key);
 bool cmac_calc(uint8_t *m, uint8_t bytes, uint8_t *data_prefix, bool check);
@@ -124,6 +124,127 @@ void EEPROM_write(uint16_t address, uint8_t data)
 
 
 
+#if EEPROM_JOURNAL
+/*!
+ *  Journal of often changed config items (\ref config_journaled)
+ *  - entries are written round robin to \ref ee_journal, lap bit is inverted
+ *    on every wrap, first entry with other lap bit than entry 0 is head
+ *  - newest entry of item after last compaction is valid value, without
+ *    entry the value is in ee_config
+ *  - compaction (copy newest values to ee_config) is done on power-up and
+ *    when journal is full, ee_config cell is written only once per JOURNAL_N
+ *    changes
+ */
+static uint8_t journal_head;                    //!< next written entry
+static uint8_t journal_lap;                     //!< lap bit of next written entry
+static uint8_t journal_used = JOURNAL_N;        //!< entries written after last compaction
+
+/*!
+ *******************************************************************************
+ *  find newest journal entry for config item
+ *
+ *  \returns entry index or -1
+ ******************************************************************************/
+static int8_t journal_find(uint8_t idx)
+{
+	uint8_t i = journal_head;
+	uint8_t n;
+
+	for (n = journal_used; n > 0; n--)
+	{
+		i = (i + JOURNAL_N - 1) % JOURNAL_N;
+		if ((EEPROM_read((uint16_t)&ee_journal[i][0]) & 0x7f) == idx)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*!
+ *******************************************************************************
+ *  stored value of config item, same as config_read(idx,CONFIG_VALUE) for
+ *  items out of journal
+ ******************************************************************************/
+uint8_t eeprom_config_value(uint8_t idx)
+{
+	if (config_journaled(idx))
+	{
+		int8_t i = journal_find(idx);
+		if (i >= 0)
+		{
+			return EEPROM_read((uint16_t)&ee_journal[i][1]);
+		}
+	}
+	return config_read(idx, CONFIG_VALUE);
+}
+
+/*!
+ *******************************************************************************
+ *  copy newest journal values to ee_config
+ ******************************************************************************/
+static void journal_compact(void)
+{
+	uint8_t idx;
+
+	for (idx = 0; idx < CONFIG_RAW_SIZE; idx++)
+	{
+		if (config_journaled(idx))
+		{
+			uint8_t v = eeprom_config_value(idx);
+			if (v != config_read(idx, CONFIG_VALUE))
+			{
+				config_write(idx, v);
+			}
+		}
+	}
+	journal_used = 0;
+}
+
+/*!
+ *******************************************************************************
+ *  find journal head after power-up
+ ******************************************************************************/
+static void journal_init(void)
+{
+	uint8_t lap = EEPROM_read((uint16_t)&ee_journal[0][0]) & 0x80;
+	uint8_t i;
+
+	for (i = 1; i < JOURNAL_N; i++)
+	{
+		if ((EEPROM_read((uint16_t)&ee_journal[i][0]) & 0x80) != lap)
+		{
+			break;
+		}
+	}
+	journal_lap = (i < JOURNAL_N) ? lap : (lap ^ 0x80);
+	journal_head = i % JOURNAL_N;
+	journal_used = JOURNAL_N;
+}
+
+/*!
+ *******************************************************************************
+ *  append value to journal
+ *
+ *  \note value is written first, broken write can damage only oldest entry
+ ******************************************************************************/
+static void journal_write(uint8_t idx, uint8_t value)
+{
+	if (journal_used >= JOURNAL_N)
+	{
+		journal_compact();
+	}
+	EEPROM_write((uint16_t)&ee_journal[journal_head][1], value);
+	EEPROM_write((uint16_t)&ee_journal[journal_head][0], journal_lap | idx);
+	journal_used++;
+	if (++journal_head >= JOURNAL_N)
+	{
+		journal_head = 0;
+		journal_lap ^= 0x80;
+	}
+}
+#endif
+
 /*!
  *******************************************************************************
  *  Init configuration storage
@@ -138,6 +259,9 @@ void eeprom_config_init(bool restore_default)
 #if (NANODE == 1 || JEENODE == 1)
 	// set to allow erase and write in one operation
 	EECR |= (EEPM1 | EEPM0);
+#endif
+#if EEPROM_JOURNAL
+	journal_init();
 #endif
 	for (i = 0; i < CONFIG_RAW_SIZE; i++)
 	{
@@ -157,6 +281,9 @@ void eeprom_config_init(bool restore_default)
 		eeprom_config_save(i);                                  // update if default value is restored
 		config_ptr++;
 	}
+#if EEPROM_JOURNAL
+	journal_compact();
+#endif
 }
 
 
@@ -177,6 +304,13 @@ void eeprom_config_save(uint8_t idx)
 			{
 				config_raw[idx] = config_default(idx);  // default value
 			}
+#if EEPROM_JOURNAL
+			if (config_journaled(idx))
+			{
+				journal_write(idx, config_raw[idx]);
+				return;
+			}
+#endif
 			config_write(idx, config_raw[idx]);
 		}
 	}
@@ -0,0 +1,92 @@
+/*
+ *  Open HR20
+ *
+ *  target:     ATmega169 in Honnywell Rondostat HR20E / ATmega8
+ *
+ *  compiler:   WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file       ota.h
+ * \brief      radio firmware update, frames between master and slave bootloader
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ *
+ * Update sequence:
+ *  - command F (through master queue) writes ee_ota descriptor and reboots slave
+ *  - bootloader finds descriptor and keeps RFM receiver on
+ *  - master sends data frames (serial command F), bootloader writes flash
+ *    page by page and answers every frame with ACK (next expected page/block)
+ *  - after last page bootloader checks CRC of image and starts application
+ *
+ * Delta update (OTA_DELTA in pages): data frames carry patch chunks instead
+ * of pages, page in frame is chunk index, block is index inside of chunk.
+ * Chunk 0 is header: old_pages old_crc_h old_crc_l, bootloader checks old
+ * image before any flash write. Other chunks: page (| OTA_DELTA_LAST) and
+ * ops building this page in RAM, chunk is padded to OTA_BLOCK:
+ *  - 0nnnnnnn: n+1 literal bytes follow
+ *  - 1nnnnnnn addr_h addr_l: copy n+1 bytes from current flash content
+ * Unchanged pages have no chunk. Any failure (old image CRC, new image CRC)
+ * switches bootloader to full update, it is reported by status.
+ *
+ * Frame: len|0x80 OTA_MARK addr cmd ... CMAC[4]
+ * It is sent outside of time slots, sync packet has year (never OTA_MARK)
+ * on the same position. CMAC is calculated with OTA_MAC_PREFIX, so data
+ * frames are never accepted as sync packets by running slaves.
+ */
+
+#pragma once
+
+#define OTA_MARK 0xff           //!< byte after length
+#define OTA_BLOCK 16            //!< data bytes in one frame, master rx line must fit to RX_BUFF_SIZE
+#define OTA_PAGE 128            //!< flash page, SPM_PAGESIZE of ATmega169
+#define OTA_BLOCKS_PER_PAGE (OTA_PAGE / OTA_BLOCK)
+#define OTA_PAGES_MAX 112       //!< application section 14kB (BOOTSZ=00, bootloader at 0x3800)
+
+#define OTA_CMD_DATA 'd'        //!< master: page block data[OTA_BLOCK]
+#define OTA_CMD_QUERY 'q'       //!< master: ask for state
+#define OTA_CMD_ACK 'a'         //!< bootloader: page block (next expected) status
+
+#define OTA_FRAME_DATA (1 + 5 + OTA_BLOCK + 4)
+#define OTA_FRAME_QUERY (1 + 3 + 4)
+#define OTA_FRAME_ACK (1 + 6 + 4)
+
+#define OTA_ST_RUN 0            //!< waiting for page/block
+#define OTA_ST_DONE 1           //!< image verified, application is started
+#define OTA_ST_CRC 2            //!< image CRC does not match, continue from page 0
+#define OTA_ST_BASE 3           //!< old image for delta does not match, continue as full update
+#define OTA_ST_DELTA 0x80       //!< flag, bootloader expects patch chunks
+
+#define OTA_DELTA 0x80          //!< flag in pages of command F and descriptor
+#define OTA_DELTA_COPY 0x80     //!< op flag, copy from flash
+#define OTA_DELTA_LAST 0x80     //!< flag in page byte of last chunk
+
+/*! key prefix of OTA CMAC, differs from sync packets (no prefix) and data packets (RTC) */
+#define OTA_MAC_PREFIX { 'H', 'R', '2', '0', 'O', 'T', 'A', 0 }
+
+/*! ee_ota descriptor, fixed address, bootloader does not know config_t
+ *  [0] index of RFM_devaddr in ee_config (security_key follows), 0xff = no update
+ *  [1] pages of image, | OTA_DELTA for delta update
+ *  [2] [3] CRC16 of image (_crc_xmodem_update), high byte first
+ *  [4] next page (chunk) to write, 0 = flash not touched yet, 0xff = start again from page 0 */
+#define OTA_EE_DESC 0x0bb
+#define OTA_EE_DESC_SIZE 5
+#define OTA_EE_CONFIG 0x0c0     //!< address of ee_config, 4 bytes per item, value is first
@@ -0,0 +1,186 @@
+/*
+ *  Open HR20
+ *
+ *  target:     ATmega169 in Honnywell Rondostat HR20E / ATmega8, host side tools
+ *
+ *  compiler:   WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file       protocol.h
+ * \brief      commands and replies of wireless protocol between master and slave
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ *
+ * One table for all sides: slave (src/com.c), master (rfm-master/com.c)
+ * and host tools (tools/hr20bin). Record in frame is command character
+ * (| 0x80 in reply) followed by fixed number of bytes given by table,
+ * replies 'V' (text up to '\n') and 'J' (length byte) are variable.
+ * Records are decoded in place from frame buffer by offsets below.
+ *
+ * New command needs only one line in PROTO_COMMANDS, duplicated command
+ * or reply longer than PROTO_REPLY_MAX does not compile.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define PROTO_REPLY 0x80        //!< flag in command byte of reply
+#define PROTO_VAR 0             //!< reply length is given by content
+#define PROTO_REPLY_MAX 40      //!< one reply must fit into sync frame (WIRELESS_BUF_MAX)
+
+/* reply formats */
+#define PROTO_FMT_RAW 0         //!< unknown, hex dump
+#define PROTO_FMT_STATUS 1      //!< status record below
+#define PROTO_FMT_WORD 2        //!< idx value_h value_l
+#define PROTO_FMT_BYTE 3        //!< idx value
+#define PROTO_FMT_VALUE 4       //!< value
+#define PROTO_FMT_PROFILE 5     //!< idx motor_profile_t
+#define PROTO_FMT_TRACE 6       //!< seq len words[len / 2]
+#define PROTO_FMT_TEXT 7        //!< text up to '\n'
+
+/* status record 'D', 'A', 'M' */
+#define PROTO_STATUS_MIN 1      //!< minute | test_auto 0x40 | mode_auto 0x80
+#define PROTO_STATUS_SEC 2      //!< second | window 0x40 | locked 0x80
+#define PROTO_STATUS_ERROR 3
+#define PROTO_STATUS_TEMP 4     //!< temp_average, 1/100 C, big endian
+#define PROTO_STATUS_BAT 6      //!< bat_average, mV, big endian
+#define PROTO_STATUS_WANTED 8   //!< CTL_temp_wanted, calc_temp() units
+#define PROTO_STATUS_VALVE 9    //!< %
+#define PROTO_STATUS_LEN 10
+
+#define PROTO_STATUS_TEST_AUTO 0x40
+#define PROTO_STATUS_MODE_AUTO 0x80
+#define PROTO_STATUS_WINDOW 0x40
+#define PROTO_STATUS_LOCKED 0x80
+#define PROTO_STATUS_TIME_MASK 0x3f
+
+#define PROTO_PROFILE_SIZE 16   //!< sizeof(motor_profile_t)
+#define PROTO_TRACE_LEN 2       //!< offset of length byte in 'J' reply
+#define PROTO_TRACE_MAX 16      //!< words in 'J' reply
+
+/* 'G' / 'S' index of RFM_freqAdjust on slave, its position in config_t
+ * depends on build options ('G' 0xff returns EE_LAYOUT)
+ */
+#define PROTO_CONFIG_FREQ_ADJUST 0xfe
+
+/*
+ * X(command, request bytes, reply bytes including command, reply format)
+ */
+#define PROTO_COMMANDS(X) \
+	X('V', 0, PROTO_VAR, PROTO_FMT_TEXT) \
+	X('D', 0, PROTO_STATUS_LEN, PROTO_FMT_STATUS) \
+	X('A', 1, PROTO_STATUS_LEN, PROTO_FMT_STATUS) \
+	X('M', 1, PROTO_STATUS_LEN, PROTO_FMT_STATUS) \
+	X('T', 1, 4, PROTO_FMT_WORD) \
+	X('R', 1, 4, PROTO_FMT_WORD) \
+	X('W', 3, 4, PROTO_FMT_WORD) \
+	X('Z', 3, 4, PROTO_FMT_WORD) \
+	X('G', 1, 3, PROTO_FMT_BYTE) \
+	X('S', 2, 3, PROTO_FMT_BYTE) \
+	X('K', 2, 3, PROTO_FMT_BYTE) \
+	X('B', 2, 3, PROTO_FMT_RAW) \
+	X('L', 1, 2, PROTO_FMT_VALUE) \
+	X('U', 1, 2, PROTO_FMT_VALUE) \
+	X('F', 3, 2, PROTO_FMT_VALUE) \
+	X('P', 1, 2 + PROTO_PROFILE_SIZE, PROTO_FMT_PROFILE) \
+	X('J', 1, PROTO_VAR, PROTO_FMT_TRACE) \
+	X('N', 1, 4, PROTO_FMT_WORD)
+
+#define PROTO_CHECK(c, req, rep, fmt) && ((rep) <= PROTO_REPLY_MAX) && ((req) < PROTO_REPLY_MAX)
+typedef char proto_check_t[(1 PROTO_COMMANDS(PROTO_CHECK)) ? 1 : -1];
+typedef char proto_check_trace_t[(3 + 2 * PROTO_TRACE_MAX <= PROTO_REPLY_MAX) ? 1 : -1];
+#undef PROTO_CHECK
+
+/*!
+ *******************************************************************************
+ *  bytes of command parameters
+ ******************************************************************************/
+static inline uint8_t proto_request_len(uint8_t cmd)
+{
+	switch (cmd)
+	{
+#define PROTO_X(c, req, rep, fmt) case c: return req;
+		PROTO_COMMANDS(PROTO_X)
+#undef PROTO_X
+	default:
+		return 0;
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  format of reply
+ ******************************************************************************/
+static inline uint8_t proto_reply_format(uint8_t cmd)
+{
+	switch (cmd & ~PROTO_REPLY)
+	{
+#define PROTO_X(c, req, rep, fmt) case c: return fmt;
+		PROTO_COMMANDS(PROTO_X)
+#undef PROTO_X
+	default:
+		return PROTO_FMT_RAW;
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  size of reply record at d
+ *  \param len bytes available in frame
+ *  \returns size, can be bigger than len for incomplete record,
+ *           unknown command takes rest of frame
+ ******************************************************************************/
+static inline int16_t proto_reply_size(const uint8_t *d, int16_t len)
+{
+	int16_t i;
+
+	switch (d[0] & ~PROTO_REPLY)
+	{
+#define PROTO_X(c, req, rep, fmt) case c: if (rep != PROTO_VAR) return rep; break;
+		PROTO_COMMANDS(PROTO_X)
+#undef PROTO_X
+	default:
+		return len;
+	}
+	if (proto_reply_format(d[0]) == PROTO_FMT_TRACE)
+	{
+		return (len > PROTO_TRACE_LEN) ? (PROTO_TRACE_LEN + 1 + d[PROTO_TRACE_LEN]) : (PROTO_TRACE_LEN + 1);
+	}
+	for (i = 1; i < len; i++)
+	{
+		if (d[i] == '\n')
+		{
+			return i + 1;
+		}
+	}
+	return len + 1;
+}
+
+/*!
+ *******************************************************************************
+ *  big endian word of record
+ ******************************************************************************/
+static inline uint16_t proto_word(const uint8_t *d, uint8_t offset)
+{
+	return ((uint16_t)d[offset] << 8) | d[offset + 1];
+}
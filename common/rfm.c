@@ -94,6 +94,38 @@ uint16_t rfm_spi16(uint16_t outval)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Frequency Setting Command with RFM_freqAdjust
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static void rfm_set_frequency(void)
+{
+#if (RFM_TUNING > 0)
+	int8_t adjust = config.RFM_freqAdjust;
+#else
+	int8_t adjust = 0;
+#endif
+	RFM_SPI_16(
+		RFM_FREQUENCY |
+		(RFM_FREQ_Band(RFM_FREQ_MAIN)(RFM_FREQ_DEC) + adjust)
+	);
+}
+
+/*!
+ *******************************************************************************
+ *  apply changed config.RFM_freqAdjust without reinit
+ *
+ *  \note called from main loop, SPI is shared with RFM interrupt
+ ******************************************************************************/
+void RFM_freq_update(void)
+{
+	cli();
+	rfm_set_frequency();
+	sei();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Initialise RF module
@@ -126,15 +158,7 @@ void RFM_init(void)
 	//	 );
 
 	// 3. Frequency Setting Command
-#if (RFM_TUNING > 0)
-	int8_t adjust = config.RFM_freqAdjust;
-#else
-	int8_t adjust = 0;
-#endif
-	RFM_SPI_16(
-		RFM_FREQUENCY |
-		(RFM_FREQ_Band(RFM_FREQ_MAIN)(RFM_FREQ_DEC) + adjust)
-	);
+	rfm_set_frequency();
 
 	// 4. Data Rate Command
 	RFM_SPI_16(RFM_SET_DATARATE(RFM_BAUD_RATE));
@@ -261,6 +285,7 @@ void RFM_interrupt(uint8_t pine)
  ******************************************************************************/
 // RFM module interupt
 volatile uint8_t afc = 0;
+volatile uint16_t rfm_rx_status = 0;
 ISR(RFM_INT_vect)
 {
 #if (JEENODE == 1)
@@ -289,13 +314,13 @@ ISR(RFM_INT_vect)
 		else if (rfm_mode == rfmmode_rx)
 		{
 			rfm_framebuf[rfm_framepos++] = RFM_READ_FIFO();
-#if (RFM_TUNING > 0)
-			if (rfm_framepos == 6)   // get AFC value
+			if (rfm_framepos == 6)   // get AFC value and RSSI, see link.c
 			{
+				rfm_rx_status = status;
+#if (RFM_TUNING > 0)
 				afc = status & 0x1f;
-			}
-
 #endif
+			}
 			if (rfm_framepos >= RFM_FRAME_MAX)
 			{
 				rfm_mode = rfmmode_rx_owf;
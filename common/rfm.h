@@ -500,6 +500,7 @@
 
 #include <stdint.h>
 void RFM_init(void);
+void RFM_freq_update(void);
 uint16_t rfm_spi16(uint16_t outval);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -541,6 +542,8 @@ extern rfm_mode_t rfm_mode;
 
 #if !defined(MASTER_CONFIG_H)
 void RFM_interrupt(uint8_t pine);
+#else
+extern volatile uint16_t rfm_rx_status; // status word on 6th byte of last received frame
 #endif // !defined(MASTER_CONFIG_H)
 
 #define rfm_start_tx()
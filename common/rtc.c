@@ -49,6 +49,7 @@
 #if !defined(MASTER_CONFIG_H)
 #include "eeprom.h"
 #include "menu.h"
+#include "uart.h"
 #endif
 
 // Vars
@@ -66,7 +67,8 @@ rtc_t RTC = {
 #endif
 };
 
-uint8_t RTC_DS;         //!< Daylightsaving Flag
+uint16_t RTC_DST_table[2];      //!< daylight saving transitions of actual year, see \ref RTC_DST_KEY
+uint16_t RTC_DST_next;          //!< next daylight saving transition or \ref RTC_DST_NONE
 #ifdef RTC_TICKS
 uint32_t RTC_Ticks = 0; //!< Ticks since last Reset
 #endif
@@ -75,7 +77,9 @@ uint32_t RTC_Ticks = 0; //!< Ticks since last Reset
 static void    RTC_AddOneDay(void);             // add one day to actual date
 static uint8_t RTC_DaysOfMonth(void);           // how many days in (RTC_MM, RTC_YY)
 static void    RTC_SetDayOfWeek(void);          // calc day of week (RTC_DD, RTC_MM, RTC_YY)
-static bool    RTC_IsLastSunday(void);          // check actual date if last sun in mar/oct
+static uint8_t RTC_CalcDayOfWeek(uint8_t mm, uint8_t dd);       // calc day of week for actual year
+static void    RTC_DSTTableUpdate(void);        // calc daylight saving transitions for actual year
+static void    RTC_DSTNextUpdate(void);         // find next daylight saving transition
 
 // year mod 100 = 0 is only every 400 years a leap year
 // we calculate only till the year 2255, so don't care
@@ -129,7 +133,8 @@ void RTC_Init(void)
 	TIMSK |= _BV(OCIE1A);
 #endif
 
-	// day of week
+	// daylight saving table and day of week
+	RTC_DSTTableUpdate();
 	RTC_SetDayOfWeek();
 
 	//! \note OCR2A register and interrupt is used in \ref keyboard.c
@@ -167,6 +172,7 @@ void RTC_SetMonth(int8_t month)
 void RTC_SetYear(uint8_t year)
 {
 	RTC.YY = year;
+	RTC_DSTTableUpdate();
 	RTC_SetDayOfWeek();
 }
 
@@ -178,6 +184,7 @@ void RTC_SetYear(uint8_t year)
 void RTC_SetHour(int8_t hour)
 {
 	RTC.hh = (uint8_t)(hour + 24) % 24;
+	RTC_DSTNextUpdate();
 }
 
 
@@ -414,6 +421,72 @@ uint8_t RTC_ActualTimerTemperatureType(bool exact)
 	}
 	return (data >> 12) & 3;
 }
+
+#if OPTIMAL_START
+/*!
+ *******************************************************************************
+ *
+ *  find first timer of day after given time
+ *
+ *  \returns index of timer, -1 if not found
+ *
+ ******************************************************************************/
+static int8_t RTC_FindNextTimerRawIndex(uint8_t dow, int16_t time_minutes)
+{
+	uint8_t idx_raw = timers_get_raw_index(dow, 0);
+	uint8_t stop = idx_raw + RTC_TIMERS_PER_DOW;
+	uint16_t mintime = 24 * 60;
+	int8_t raw_index = -1;
+
+	for (; idx_raw < stop; idx_raw++)
+	{
+		int16_t table_time = eeprom_timers_read_raw(idx_raw) & 0x0fff;
+		if ((table_time > time_minutes) && (table_time < mintime))
+		{
+			mintime = table_time;
+			raw_index = idx_raw;
+		}
+	}
+	return raw_index;
+}
+
+/*!
+ *******************************************************************************
+ *
+ *  get next timer event, today or tomorrow
+ *
+ *  \param *type temperature type of next timer [see to \ref c2temp]
+ *
+ *  \returns minutes to next timer, 0xffff if there is no timer
+ *
+ ******************************************************************************/
+uint16_t RTC_NextTimer(uint8_t *type)
+{
+	uint16_t minutes = RTC.hh * 60 + RTC.mm;
+	uint8_t dow = ((config.timer_mode == 1) ? RTC.DOW : 0);
+	int8_t raw_index = RTC_FindNextTimerRawIndex(dow, minutes);
+	uint16_t add = 0;
+
+	if (raw_index < 0)
+	{
+		if (dow > 0)
+		{
+			dow = dow % 7 + 1;
+		}
+		raw_index = RTC_FindNextTimerRawIndex(dow, -1);
+		add = 24 * 60;
+		if (raw_index < 0)
+		{
+			return 0xffff;
+		}
+	}
+	{
+		uint16_t data = eeprom_timers_read_raw(raw_index);
+		*type = (data >> 12) & 3;
+		return (data & 0xfff) + add - minutes;
+	}
+}
+#endif
 #endif // !defined(MASTER_CONFIG_H)
 
 /*!
@@ -426,8 +499,9 @@ uint8_t RTC_ActualTimerTemperatureType(bool exact)
  *    - process daylight saving
  *       - last sunday in march 1:59:59 -> 3:00:00
  *       - last sunday in october 2:59:59 -> 2:00:00 <BR>
- *         ONLY ONE TIME -> set FLAG RTC_DS <BR>
- *         reset FLAG RTC_DS on next day
+ *         ONLY ONE TIME -> \ref RTC_DST_next is moved to next transition
+ *       - transitions are precalculated in \ref RTC_DSTTableUpdate,
+ *         here is only one compare each hour
  *
  *  \returns true if minutes changed, false otherwise
  ******************************************************************************/
@@ -452,23 +526,19 @@ void RTC_AddOneSecond(void)
 				RTC.hh = 0;
 				RTC_AddOneDay();
 			}
-			// start of summertime: March, 2:00:00 ?
-			if ((RTC.MM == 3) && (RTC.hh == 2))
+			if (RTC_DST_KEY(RTC.MM, RTC.DD, RTC.hh) == RTC_DST_next)
 			{
-				// Last Sunday ?
-				if (RTC_IsLastSunday())
+				if (RTC_DST_next == RTC_DST_table[0])
 				{
+					// start of summertime
 					RTC.hh++; // 2:00 -> 3:00
+					RTC_DST_next = RTC_DST_table[1];
 				}
-			}
-			// end of summertime: October, 03:00, RTC_DS == 0
-			if ((RTC.MM == 10) && (RTC.hh == 3) && (RTC_DS == 0))
-			{
-				// Last Sunday ?
-				if (RTC_IsLastSunday())
+				else
 				{
+					// end of summertime
 					RTC.hh--; // 3:00 -> 2:00
-					RTC_DS = 1;
+					RTC_DST_next = RTC_DST_NONE;
 				}
 			}
 		}
@@ -498,9 +568,8 @@ static void RTC_AddOneDay(void)
 		{
 			RTC.MM = 1;
 			RTC.YY++;
+			RTC_DSTTableUpdate();
 		}
-		// Clear Daylight saving Flag
-		RTC_DS = 0;
 	}
 	// next day of week
 	RTC.DOW = (RTC.DOW % 7) + 1; // Monday = 1 Sat=7
@@ -532,29 +601,74 @@ static uint8_t RTC_DaysOfMonth()
 /*!
  *******************************************************************************
  *
- *  \returns \ref true if actual date is last sunday in march or october
+ *  calculate daylight saving transitions for actual year
+ *
+ *  \note
+ *     - last sunday in march 2:00 and last sunday in october 3:00
+ *     - called only on set date and year rollover
+ *
+ ******************************************************************************/
+static void RTC_DSTTableUpdate(void)
+{
+	// 31.3. and 31.10. day of week, 7=sunday
+	RTC_DST_table[0] = RTC_DST_KEY(3, 31 - (RTC_CalcDayOfWeek(3, 31) % 7), 2);
+	RTC_DST_table[1] = RTC_DST_KEY(10, 31 - (RTC_CalcDayOfWeek(10, 31) % 7), 3);
+	RTC_DSTNextUpdate();
+}
+
+
+/*!
+ *******************************************************************************
+ *
+ *  find next daylight saving transition for actual date and time
+ *
+ *  \note time between 2:00 and 3:00 on end of summertime is ambiguous,
+ *        it stays wintertime if transition was done already (time set
+ *        again in this hour), otherwise it is taken as summertime.
+ *        \ref RTC_SetDST can correct it.
  *
  ******************************************************************************/
-static bool RTC_IsLastSunday(void)
+static void RTC_DSTNextUpdate(void)
 {
-	if (RTC.DOW != 7)       // sunday ?
+	uint16_t now = RTC_DST_KEY(RTC.MM, RTC.DD, RTC.hh);
+
+	if (now < RTC_DST_table[0])
 	{
-		return 0;       // not sunday
+		RTC_DST_next = RTC_DST_table[0];
 	}
-	// March or October ?
-	if (RTC.MM == 3)
+	else if ((now < RTC_DST_table[1])
+		 && ((RTC_DST_next != RTC_DST_NONE) || (now < RTC_DST_table[1] - 1)))
 	{
-		// last seven days of month
-		return RTC.DD > (31 - 7);
+		RTC_DST_next = RTC_DST_table[1];
 	}
-	else if (RTC.MM == 10)
+	else
 	{
-		// last seven days of month
-		return RTC.DD > (30 - 7);
+		RTC_DST_next = RTC_DST_NONE;
 	}
-	else
+}
+
+
+/*!
+ *******************************************************************************
+ *
+ *  set daylight saving state received from master
+ *
+ *  \param dst true for summertime
+ *
+ ******************************************************************************/
+void RTC_SetDST(bool dst)
+{
+	RTC_DSTNextUpdate();
+	if (dst)
+	{
+		if (RTC_DST_next == RTC_DST_NONE)
+		{
+			RTC_DST_next = RTC_DST_table[1];
+		}
+	}
+	else if (RTC_DST_next == RTC_DST_table[1])
 	{
-		return 0; // not march or october
+		RTC_DST_next = RTC_DST_NONE;
 	}
 }
 
@@ -584,14 +698,14 @@ static const uint16_t daysInYear [12] PROGMEM = {
 	31 + 28 + 31 + 30 + 31 + 30 + 31 + 31 + 30 + 31 + 30
 };
 
-static void RTC_SetDayOfWeek(void)
+static uint8_t RTC_CalcDayOfWeek(uint8_t mm, uint8_t dd)
 {
 	uint16_t day_of_year;
 	uint16_t tmp_dow;
 
 	// Day of year
-	day_of_year = pgm_read_word(&(daysInYear[RTC.MM - 1])) + RTC.DD;
-	if (RTC.MM > 2)   // february
+	day_of_year = pgm_read_word(&(daysInYear[mm - 1])) + dd;
+	if (mm > 2)   // february
 	{
 		if (!RTC_NoLeapyear())
 		{
@@ -600,8 +714,14 @@ static void RTC_SetDayOfWeek(void)
 	}
 	// calc weekday
 	tmp_dow = RTC.YY + ((RTC.YY - 1) / 4) - ((RTC.YY - 1) / 100) + day_of_year;
+	return (uint8_t)((tmp_dow + 5) % 7) + 1;
+}
+
+static void RTC_SetDayOfWeek(void)
+{
 	// set DOW
-	RTC.DOW = (uint8_t)((tmp_dow + 5) % 7) + 1;
+	RTC.DOW = RTC_CalcDayOfWeek(RTC.MM, RTC.DD);
+	RTC_DSTNextUpdate();
 
 #if !defined(MASTER_CONFIG_H)
 	menu_update_hourbar((config.timer_mode == 1) ? RTC.DOW : 0);
@@ -611,6 +731,9 @@ static void RTC_SetDayOfWeek(void)
 uint8_t RTC_timer_todo = 0;
 uint8_t RTC_timer_done = 0;
 static uint8_t RTC_timer_time[RTC_TIMERS];
+#if HAS_RECALIBRATE_RCO
+static volatile uint16_t RTC_rco_capture;
+#endif
 #if defined(MASTER_CONFIG_H)
 static uint8_t RTC_next_compare;
 #endif
@@ -723,6 +846,13 @@ ISR(TIMER2_COMP_vect)
 {
 	uint8_t t2 = TCNT2 - 1;
 
+#if HAS_RECALIBRATE_RCO
+	// capture first, latency must be same for both edges of measurement
+	if ((RTC_timer_todo & _BV(RTC_TIMER_RCO)) && (t2 == RTC_timer_time[RTC_TIMER_RCO - 1]))
+	{
+		RTC_rco_capture = TCNT1;
+	}
+#endif
 	task |= TASK_RTC;
 #if (DEBUG_PRINT_RTC_TICKS)
 	COM_putchar('%');
@@ -890,3 +1020,136 @@ void calibrate_rco(void)
 	} while (--cycles);
 }
 #endif
+
+#if HAS_RECALIBRATE_RCO
+/*!
+ *******************************************************************************
+ *
+ *  Background recalibration of the internal OSCCAL byte,
+ *  using the external 32,768 kHz crystal as reference
+ *
+ *  \note
+ *  - calibrate_rco() can't be used after init, it reprograms timer2 (RTC)
+ *  - timer1 (unused on HR20) counts CPU clock between two compare events
+ *    of running timer2, RCO_TICKS/256 s in idle sleep
+ *  - one OSCCAL step per second, power save between steps
+ *  - started when temperature changes or battery voltage drops,
+ *    RC oscillator drifts with both
+ *
+ ******************************************************************************/
+#define RCO_TICKS      8        // measurement length in 1/256 s
+#define RCO_COUNT      ((int16_t)((F_CPU / 8) * RCO_TICKS / 256))       // timer1 clk/8
+#define RCO_TOLERANCE  (RCO_COUNT / 512)        // 0.2%, less than one OSCCAL step
+#define RCO_MAX_STEPS  32
+#define RCO_TEMP_DELTA 300      // 1/100 C
+#define RCO_BAT_DELTA  100      // mV
+
+uint8_t RTC_rco_state = RTC_RCO_IDLE;
+static uint16_t RTC_rco_start;
+static uint8_t RTC_rco_steps;
+static int8_t RTC_rco_dir;
+static int16_t RTC_rco_temp;    // temperature of last recalibration
+static int16_t RTC_rco_bat = 0; // battery voltage of last recalibration, 0 = never
+
+/*!
+ *******************************************************************************
+ *  start one measurement, timer1 runs until RTC_RcoTimer finish it
+ ******************************************************************************/
+static void RTC_RcoMeasure(void)
+{
+	PRR &= ~(1 << PRTIM1);
+	TCCR1A = 0;
+	TCCR1B = (1 << CS11);   // clk/8
+	RTC_rco_state = RTC_RCO_START;
+	RTC_timer_set(RTC_TIMER_RCO, TCNT2 + 2);
+}
+
+/*!
+ *******************************************************************************
+ *  stop timer1 and finish recalibration
+ ******************************************************************************/
+static void RTC_RcoStop(uint8_t state)
+{
+	TCCR1B = 0;
+	PRR |= (1 << PRTIM1);
+	RTC_rco_state = state;
+}
+
+/*!
+ *******************************************************************************
+ *
+ *  check conditions for recalibration, call it every second
+ *
+ *  \param temp actual temperature in 1/100 C
+ *  \param bat actual battery voltage in mV
+ *
+ ******************************************************************************/
+void RTC_RcoCheck(int16_t temp, int16_t bat)
+{
+	if (RTC_rco_state == RTC_RCO_IDLE)
+	{
+		int16_t dt = temp - RTC_rco_temp;
+		if ((RTC_rco_bat != 0)
+		    && (dt <= RCO_TEMP_DELTA) && (dt >= -RCO_TEMP_DELTA)
+		    && (bat + RCO_BAT_DELTA >= RTC_rco_bat))
+		{
+			return;
+		}
+		RTC_rco_temp = temp;
+		RTC_rco_bat = bat;
+		RTC_rco_steps = RCO_MAX_STEPS;
+		RTC_rco_dir = 0;
+	}
+	else if (RTC_rco_state != RTC_RCO_WAIT)
+	{
+		return;
+	}
+	RTC_RcoMeasure();
+}
+
+/*!
+ *******************************************************************************
+ *
+ *  RTC_TIMER_RCO event, called from main loop
+ *
+ ******************************************************************************/
+void RTC_RcoTimer(void)
+{
+	if (RTC_rco_state == RTC_RCO_START)
+	{
+		RTC_rco_start = RTC_rco_capture;
+		RTC_rco_state = RTC_RCO_END;
+		RTC_timer_set(RTC_TIMER_RCO, RTC_timer_time[RTC_TIMER_RCO - 1] + RCO_TICKS);
+		return;
+	}
+	if (RTC_rco_state != RTC_RCO_END)
+	{
+		return;
+	}
+
+	int16_t err = (int16_t)(RTC_rco_capture - RTC_rco_start) - RCO_COUNT;
+	int8_t dir = 0;
+	if (err > RCO_TOLERANCE)
+	{
+		dir = -1;
+	}
+	else if (err < -RCO_TOLERANCE)
+	{
+		dir = 1;
+	}
+
+	if ((dir == 0) || (dir == -RTC_rco_dir))
+	{
+		// in tolerance or crossed the optimum, smaller step is not possible
+		RTC_RcoStop(RTC_RCO_IDLE);
+		return;
+	}
+	if (!UART_need_clock())
+	{
+		// do not change baudrate during communication, try it again next second
+		OSCCAL += dir;
+		RTC_rco_dir = dir;
+	}
+	RTC_RcoStop((--RTC_rco_steps == 0) ? RTC_RCO_IDLE : RTC_RCO_WAIT);
+}
+#endif
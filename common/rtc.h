@@ -40,6 +40,10 @@
 *   Macros
 *****************************************************************************/
 
+//! daylight saving transition key, compare of keys is compare of date and hour
+#define RTC_DST_KEY(mm, dd, hh) (((uint16_t)(mm) << 10) | ((uint16_t)(dd) << 5) | (uint16_t)(hh))
+#define RTC_DST_NONE 0xffff     //!< no more daylight saving transition in actual year
+
 //! How many timers per day of week, original 4 we use 8
 #define RTC_TIMERS_PER_DOW    8
 
@@ -58,19 +62,24 @@
 
 //! Do we support calibrate_rco
 #define     HAS_CALIBRATE_RCO     0
+#define     HAS_RECALIBRATE_RCO   0     // master runs from crystal
 #else
 #define RTC_TIMER_KB  1     // keyboard timer
 #if (RFM == 1)
 #define RTC_TIMER_RFM 2
-#define RTC_TIMERS 2
+#define RTC_TIMER_RCO 3     // RC oscillator recalibration
+#define RTC_TIMERS 3
 #else
-#define RTC_TIMERS 1
+#define RTC_TIMER_RCO 2
+#define RTC_TIMERS 2
 #endif
 #define RTC_TIMER_CALC(t) ((uint8_t)((t * 256L) / 1000L))
 #define TCCR2A_INIT ((1 << CS22) | (1 << CS20))     // select precaler: 32.768 kHz / 128 =
 // => 1 sec between each overflow
 //! Do we support calibrate_rco
 #define     HAS_CALIBRATE_RCO     0
+//! Do we support background recalibration of RC oscillator
+#define     HAS_RECALIBRATE_RCO   1
 #endif
 
 /*****************************************************************************
@@ -142,9 +151,17 @@ void RTC_SetYear(uint8_t);
 bool RTC_DowTimerSet(rtc_dow_t, uint8_t, uint16_t, timermode_t timermode);      // set day of week timer
 uint16_t RTC_DowTimerGet(rtc_dow_t dow, uint8_t slot, timermode_t *timermode);
 uint8_t RTC_ActualTimerTemperatureType(bool exact);
+#if !defined(MASTER_CONFIG_H) && OPTIMAL_START
+uint16_t RTC_NextTimer(uint8_t *type);
+#endif
 int32_t RTC_DowTimerGetHourBar(uint8_t dow);
 void RTC_AddOneSecond(void);
 
+extern uint16_t RTC_DST_table[2];       //!< [0] start, [1] end of summertime in actual year
+extern uint16_t RTC_DST_next;           //!< next transition, RTC_DST_NONE after end of summertime
+#define RTC_IsDST() (RTC_DST_next == RTC_DST_table[1])  // summertime is active
+void RTC_SetDST(bool dst);
+
 extern uint8_t RTC_timer_done;
 extern uint8_t RTC_timer_todo;
 void RTC_timer_set(uint8_t timer_id, uint8_t time);
@@ -158,4 +175,17 @@ inline void calibrate_rco(void)
 }
 #endif
 
+#if     HAS_RECALIBRATE_RCO
+#define RTC_RCO_IDLE  0     //!< no recalibration running
+#define RTC_RCO_WAIT  1     //!< next step on next second
+#define RTC_RCO_START 2     //!< measurement, waiting for first timer2 compare
+#define RTC_RCO_END   3     //!< measurement, waiting for second timer2 compare
+extern uint8_t RTC_rco_state;
+#define RTC_rco_need_clock() (RTC_rco_state >= RTC_RCO_START)  // timer1 is stopped in power save
+void RTC_RcoCheck(int16_t temp, int16_t bat);
+void RTC_RcoTimer(void);
+#else
+#define RTC_rco_need_clock() (0)
+#endif
+
 #endif /* RTC_H */
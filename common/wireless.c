@@ -43,6 +43,10 @@
 #include "debug.h"
 #if defined(MASTER_CONFIG_H)
 #include "queue.h"
+#include "link.h"
+#if OTA_UPDATE
+#include "ota.h"
+#endif
 #else
 #include "controller.h"
 #include "task.h"
@@ -65,10 +69,6 @@ static uint8_t wireless_framebuf[WIRELESS_BUF_MAX];
 
 uint8_t wireless_buf_ptr = 0;
 
-static const uint8_t Km_upper[8] PROGMEM = {
-	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef
-};
-
 static const uint8_t wl_header[4] PROGMEM = {
 	0xaa, 0xaa, 0x2d, 0xd4
 };
@@ -79,6 +79,22 @@ static void wirelessSendPacket(void);
 static void wirelessSendPacket(bool cpy);
 #endif
 
+#if defined(MASTER_CONFIG_H) && OTA_UPDATE
+static const uint8_t ota_prefix[8] PROGMEM = OTA_MAC_PREFIX;
+
+/*!
+ *******************************************************************************
+ *  CMAC of firmware update frame, same as in bootloader
+ ******************************************************************************/
+static bool wireless_ota_mac(uint8_t *m, uint8_t bytes, bool check)
+{
+	uint8_t prefix[8];
+
+	memcpy_P(prefix, ota_prefix, sizeof(prefix));
+	return cmac_calc(m, bytes, prefix, check);
+}
+#endif
+
 
 /*!
  *******************************************************************************
@@ -86,57 +102,12 @@ static void wirelessSendPacket(bool cpy);
  ******************************************************************************/
 void crypto_init(void)
 {
-	uint8_t i;
-
-	memcpy(K_m, config.security_key, 8);
-	memcpy_P(K_m + 8, Km_upper, sizeof(Km_upper));
-	for (i = 0; i < 3 * 8; i++)
-	{
-		Keys[i] = 0xc0 + i;
-	}
-	xtea_enc(K_mac, K_mac, K_m);            /* generate K_mac low 8 bytes */
-	xtea_enc(K_enc, K_enc, K_m);            /* generate K_mac high 8 bytes  and K_enc low 8 bytes*/
-	xtea_enc(K_enc + 8, K_enc + 8, K_m);    /* generate K_enc high 8 bytes */
-	for (i = 0; i < 8; i++)                 // smaller&faster than memset
-	{
-		K1[i] = 0;
-	}
-	xtea_enc(K1, K1, K_mac);
-	asm (
-		"   movw  R30,%A0   \n"
-		"   rcall left_roll \n" /* generate K1 */
-		"   ldi r30,lo8(" STR(K2) ") \n"
-		"   ldi r31,hi8(" STR(K2) ") \n"
-		"   rcall left_roll \n" /* generate K2 */
-		:: "y" (K1)
-		: "r26", "r27", "r30", "r31"
-	);
+	cmac_init(config.security_key);
 #if defined(MASTER_CONFIG_H)
 	LED_RX_off();
 	LED_sync_off();
 #endif
 }
-/* internal function for crypto_init */
-/* use loop inside - short/slow */
-asm (
-	"left_roll:               \n"
-	"   ldd r26,Y+7           \n"
-	"   lsl r26               \n"
-	"   in r27,__SREG__       \n"   // save carry
-	"   ldi r26,7             \n"   // 8 times
-	"roll_loop:               \n"
-	"   ld __tmp_reg__,Y      \n"
-	"   out __SREG__,r27      \n"   // restore carry
-	"   rol __tmp_reg__       \n"
-	"   in r27,__SREG__       \n"   // save carry
-	"   st Z,__tmp_reg__      \n"
-	"   adiw r28,1            \n"   // Y++
-	"   adiw r30,1            \n"   // Z++
-	"   subi r26,1            \n"
-	"   brcc roll_loop        \n"   // 8 times loop
-	"   sbiw r28,8            \n"   // Y-=8
-	"   ret "
-);
 
 /*!
  *******************************************************************************
@@ -218,13 +189,16 @@ void wirelessTimer(void)
 		RFM_INT_EN();   // enable RFM interrupt
 		rfm_framepos = 0;
 		rfm_mode = rfmmode_rx;
-		wirelessTimerCase = WL_TIMER_RX_TMO;
+		wirelessTimerCase = WL_TIMER_SYNC_TMO;
 		while (ASSR & (_BV(TCR2UB)))
 		{
 			;
 		}
 		RTC_timer_set(RTC_TIMER_RFM, (uint8_t)(RTC_s256 + WLTIME_SYNC_TIMEOUT));
 		return;
+	case WL_TIMER_SYNC_TMO:
+		wl_stat[WL_STAT_SYNC_MISSED]++;
+	// no break, receiver off as on RX timeout
 	case WL_TIMER_RX_TMO:
 		if (rfm_mode != rfmmode_tx)
 		{
@@ -250,6 +224,7 @@ void wirelessTimer2(void)
 
 #if !defined(MASTER_CONFIG_H)
 wirelessTimerCase_t wirelessTimerCase = WL_TIMER_NONE;
+uint16_t wl_stat[WL_STAT_N];
 #endif
 
 /*!
@@ -335,6 +310,41 @@ void wirelessSendSync(void)
 }
 
 uint8_t wl_packet_bank = 0;
+
+#if OTA_UPDATE
+/*!
+ *******************************************************************************
+ *  wireless send firmware update frame
+ *
+ *  \note it is sent immediately, slave bootloader has receiver always on
+ *  \param *d frame without length and CMAC (OTA_MARK addr cmd ...)
+ *  \returns false if radio is busy
+ ******************************************************************************/
+bool wirelessSendOta(const uint8_t *d, uint8_t len)
+{
+	if ((rfm_mode != rfmmode_rx) || (rfm_framepos != 0))
+	{
+		return false;
+	}
+	RFM_INT_DIS();
+	RFM_TX_ON_PRE();
+	memcpy_P(rfm_framebuf, wl_header, 4);
+
+	rfm_framebuf[4] = (len + 1 + 4) | 0x80; // length, same as sync
+
+	memcpy(rfm_framebuf + 5, d, len);
+	wireless_ota_mac(rfm_framebuf + 5, len, false);
+
+	rfm_framesize = len + 4 + 1 + 4 + 2; // 4 preamble 1 length 4 signature 2 dummy
+
+	rfm_framepos = 0;
+	rfm_mode = rfmmode_tx;
+	RFM_TX_ON();
+	RFM_SPI_SELECT; // set nSEL low: from this moment SDO indicate FFIT or RGIT
+	RFM_INT_EN();   // enable RFM interrupt
+	return true;
+}
+#endif
 #else
 int8_t time_sync_tmo = 0;
 #if (WL_SKIP_SYNC)
@@ -418,6 +428,7 @@ void wirelessReceivePacket(void)
 #endif
 						}
 						time_sync_tmo = 20;
+						wl_stat[WL_STAT_SYNC]++;
 						while (ASSR & (_BV(TCR2UB)))
 						{
 							;
@@ -451,11 +462,23 @@ void wirelessReceivePacket(void)
 						RTC_SetHour(rfm_framebuf[3] & 0x1f);
 						RTC_SetMinute(rfm_framebuf[4] >> 1);
 						RTC_SetSecond((rfm_framebuf[4] & 1) ? 30 : 00);
+						if (rfm_framebuf[2] & WL_SYNC_DST_VALID)
+						{
+							RTC_SetDST((rfm_framebuf[2] & WL_SYNC_DST) != 0);
+						}
 						cli(); RTC_timer_done &= ~_BV(RTC_TIMER_RTC); sei(); // do not add one second
 						return;
 					}
 				}
 				else
+#elif OTA_UPDATE
+				if (((rfm_framebuf[0] & 0x80) == 0x80) && (rfm_framebuf[1] == OTA_MARK))
+				{
+					// answer from slave bootloader
+					mac_ok = wireless_ota_mac(rfm_framebuf + 1, (rfm_framebuf[0] & 0x7f) - 5, true);
+					COM_print_ota(rfm_framebuf + 2, (rfm_framebuf[0] & 0x7f) - 6, mac_ok);
+				}
+				else
 #endif
 				{
 					RTC.pkt_cnt += (rfm_framepos + 7 - 2 - 4) / 8;
@@ -463,6 +486,9 @@ void wirelessReceivePacket(void)
 					RTC.pkt_cnt -= (rfm_framepos + 7 - 2 - 4) / 8;
 					encrypt_decrypt(rfm_framebuf + 2, rfm_framepos - 2 - 4);
 					RTC.pkt_cnt++;
+#if defined(MASTER_CONFIG_H)
+					LINK_packet(rfm_framebuf[1], mac_ok); // before dump, it changes records
+#endif
 					COM_dump_packet(rfm_framebuf, rfm_framepos, mac_ok);
 #if defined(MASTER_CONFIG_H)
 					uint8_t addr = rfm_framebuf[1];
@@ -534,6 +560,10 @@ void wirelesTimeSyncCheck(void)
 	{
 		if ((time_sync_tmo == 0) || (time_sync_tmo < -30))
 		{
+			if (time_sync_tmo == 0)
+			{
+				wl_stat[WL_STAT_SYNC_LOST]++;
+			}
 			time_sync_tmo = 0;
 			RFM_INT_DIS();
 			RFM_FIFO_OFF();
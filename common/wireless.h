@@ -46,6 +46,9 @@ void wirelessReceivePacket(void);
 void wirelessSendSync(void);
 extern uint8_t wl_packet_bank;
 void wirelessTimer2(void);
+#if OTA_UPDATE
+bool wirelessSendOta(const uint8_t *d, uint8_t len);
+#endif
 #else
 extern bool wireless_async;
 void wirelesTimeSyncCheck(void);
@@ -75,6 +78,12 @@ extern uint32_t wl_force_flags;
 #endif
 #define WLTIME_LED_TIMEOUT (RTC_TIMER_CALC(300))        // packet blink time
 
+/* sync packet byte 1 is (month<<4)|(day>>3), bits 2 and 3 are free
+ * master sends daylight saving state in it, old slaves ignore it
+ */
+#define WL_SYNC_DST 0x04        // summertime
+#define WL_SYNC_DST_VALID 0x08  // WL_SYNC_DST is valid
+
 /* this allow to ignore defined sync packets
  * it is allowed only if last received sync not contain any communication request
  */
@@ -87,7 +96,16 @@ typedef enum
 	WL_TIMER_NONE,
 	WL_TIMER_FIRST,
 	WL_TIMER_RX_TMO,
-	WL_TIMER_SYNC // slave only
+	WL_TIMER_SYNC, // slave only
+	WL_TIMER_SYNC_TMO // slave only, no sync in window
 } wirelessTimerCase_t;
 extern wirelessTimerCase_t wirelessTimerCase;
+
+/* slave radio link counters, command 'N' returns them by index
+ */
+#define WL_STAT_SYNC 0          // received sync packets
+#define WL_STAT_SYNC_MISSED 1   // sync window without sync packet
+#define WL_STAT_SYNC_LOST 2     // time_sync_tmo expired, receiver searches sync
+#define WL_STAT_N 3
+extern uint16_t wl_stat[WL_STAT_N];
 #endif
@@ -0,0 +1,91 @@
+/* xtea.c */
+/*
+ *  This file is part of the Crypto-avr-lib/microcrypt-lib.
+ *  Copyright (C) 2008  Daniel Otte (daniel.otte@rub.de)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Author:	Daniel Otte
+ * Date:		06.06.2006
+ * License:	GPL
+ * source: https://roulette.das-labor.org/trac/browser/microcontroller-2/crypto-lib/xtea.c
+ */
+
+/*
+ * portable C version of xtea-asm.S for host builds (tools/hr20crypto),
+ * AVR targets link xtea-asm.S
+ * words of block and key are little endian like on AVR, independent of host
+ */
+
+#include <stdint.h>
+#include "xtea.h"
+
+#define XTEA_DELTA 0x9E3779B9UL
+#define XTEA_CYCLES 32
+
+static uint32_t load32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void store32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+void xtea_enc(void *dest, const void *v, const void *k)
+{
+	const uint8_t *kb = k;
+	uint32_t v0 = load32(v);
+	uint32_t v1 = load32((const uint8_t *)v + 4);
+	uint32_t key[4];
+	uint32_t sum = 0;
+	uint8_t i;
+
+	for (i = 0; i < 4; i++)
+		key[i] = load32(kb + 4 * i);
+	for (i = 0; i < XTEA_CYCLES; i++)
+	{
+		v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + key[sum & 3]);
+		sum += XTEA_DELTA;
+		v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + key[(sum >> 11) & 3]);
+	}
+	store32(dest, v0);
+	store32((uint8_t *)dest + 4, v1);
+}
+
+void xtea_dec(void *dest, const void *v, const void *k)
+{
+	const uint8_t *kb = k;
+	uint32_t v0 = load32(v);
+	uint32_t v1 = load32((const uint8_t *)v + 4);
+	uint32_t key[4];
+	uint32_t sum = (uint32_t)(XTEA_DELTA * XTEA_CYCLES);
+	uint8_t i;
+
+	for (i = 0; i < 4; i++)
+		key[i] = load32(kb + 4 * i);
+	for (i = 0; i < XTEA_CYCLES; i++)
+	{
+		v1 -= (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + key[(sum >> 11) & 3]);
+		sum -= XTEA_DELTA;
+		v0 -= (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + key[sum & 3]);
+	}
+	store32(dest, v0);
+	store32((uint8_t *)dest + 4, v1);
+}
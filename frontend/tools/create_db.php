@@ -36,6 +36,12 @@ $db->query("CREATE TABLE log (
 $db->query("CREATE INDEX log_time_addr on log (time,addr)");
 //$db->query("CREATE INDEX log_time on log (time)");
 
+// ************************************************************
+// log_latest, log_hourly, log_daily
+
+include_once "rollup.php";
+rollup_create($db);
+
 // ************************************************************
 
 $db->query("CREATE TABLE timers (
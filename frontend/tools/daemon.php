@@ -3,6 +3,12 @@
 // config part
 $RRD_HOME="/tmp/openhr20/";
 $TIMEZONE="Europe/Warsaw";
+// retention in days, 0 = keep forever
+$LOG_KEEP_DAYS=90;
+$HOURLY_KEEP_DAYS=730;
+$DAILY_KEEP_DAYS=0;
+
+include_once "rollup.php";
 
 // NOTE: this file is hudge dirty hack, will be rewriteln
 echo "OpenHR20 PHP Daemon\n";
@@ -16,7 +22,10 @@ function weights($char) {
         'W' => 4,
         'G' => 2,
         'R' => 2,
-	'T' => 2
+	'T' => 2,
+	'N' => 2,
+	'Z' => 4,
+	'J' => 4
     );
     if (isset($weights_table[$char]))
         return $weights_table[$char];
@@ -45,6 +54,7 @@ $fp=fopen("/dev/ttyUSB0","w+");
 
 $addr=-1;
 $trans=false;
+$retention_time=0;
 
 echo " <Starting>..\n";
 sendRTC($fp);
@@ -82,6 +92,10 @@ while(($line=fgets($fp,256))!==FALSE) {
     if ($line=="RTC?") {
         sendRTC($fp);
     	$debug=false;
+        if (time()-$retention_time >= 3600) {
+            rollup_retention($db,$LOG_KEEP_DAYS,$HOURLY_KEEP_DAYS,$DAILY_KEEP_DAYS);
+            $retention_time=time();
+        }
     } else if (($line=="OK") || (($line{0}=='d') && ($line{2}==' '))) {
         $debug=false;
     } else if (($line=="N0?") || ($line=="N1?")) {
@@ -221,6 +235,7 @@ while(($line=fgets($fp,256))!==FALSE) {
             if (($time % 3600)<$t) $time-=3600;
             $time = (int)($time/3600)*3600+$t;
         	$db->query("INSERT INTO log (time,addr$vars) VALUES ($time,$addr$val)\n");
+		rollup_add($db,$addr,$time,$st);
 		$rrd_file = $RRD_HOME."/openhr20_".$addr.".rrd";
 		if (file_exists ($rrd_file)) {
         		$cmnd = "rrdtool update ".$rrd_file." ".$time.":".(int)$st['real'].":".(int)$st['wanted'].":".(int)$st['valve'].":".(int)$st['window'];
@@ -0,0 +1,109 @@
+<?php
+
+// rollups of log table for web pages
+// log_latest - last record of each valve
+// log_hourly, log_daily - min/max/sum for each valve and hour/local day,
+//                         averages are sum/n
+// used by daemon.php (incremental update) and rollup_rebuild.php
+
+function rollup_create($db) {
+    $db->query("CREATE TABLE IF NOT EXISTS log_latest (
+        addr INTEGER PRIMARY KEY, 
+        time INTEGER, 
+        mode CHAR(10),
+        valve INTEGER,
+        real INTEGER,
+        wanted INTEGER,
+        battery INTEGER,
+        error INTEGER DEFAULT 0,
+        window INTEGER DEFAULT 0,
+        force INTEGER DEFAULT 0)");
+
+    foreach (array('log_hourly','log_daily') as $t) {
+        $db->query("CREATE TABLE IF NOT EXISTS $t (
+            addr INTEGER,
+            time INTEGER, 
+            n INTEGER DEFAULT 0,
+            real_min INTEGER,
+            real_max INTEGER,
+            real_sum INTEGER DEFAULT 0,
+            wanted_sum INTEGER DEFAULT 0,
+            valve_min INTEGER,
+            valve_max INTEGER,
+            valve_sum INTEGER DEFAULT 0,
+            battery_min INTEGER,
+            window_sum INTEGER DEFAULT 0,
+            PRIMARY KEY (addr,time))");
+    }
+}
+
+function rollup_day($time) {
+    return mktime(0,0,0,date('n',$time),date('j',$time),date('Y',$time));
+}
+
+// $st is array from daemon.php, same keys as columns of log table
+function rollup_add($db,$addr,$time,$st) {
+    $cols=""; $vals=""; $set="";
+    foreach ($st as $k=>$v) {
+        $v = is_int($v) ? $v : "'".$v."'";
+        $cols.=",".$k; $vals.=",".$v; $set.=",".$k."=".$v;
+    }
+    // missing columns must be reset to defaults
+    foreach (array('error','window','force') as $k) {
+        if (!isset($st[$k])) $set.=",$k=0";
+    }
+    $db->query("UPDATE log_latest SET time=$time$set WHERE addr=$addr AND time<=$time");
+    if ($db->changes()==0)
+        $db->query("INSERT OR IGNORE INTO log_latest (addr,time$cols) VALUES ($addr,$time$vals)");
+
+    $real = (int)$st['real'];
+    $wanted = (int)$st['wanted'];
+    $valve = (int)$st['valve'];
+    $battery = (int)$st['battery'];
+    $window = (int)$st['window'];
+    $buckets = array('log_hourly' => (int)($time/3600)*3600, 'log_daily' => rollup_day($time));
+    foreach ($buckets as $t=>$b) {
+        $db->query("INSERT OR IGNORE INTO $t (addr,time,real_min,real_max,valve_min,valve_max,battery_min)"
+            ." VALUES ($addr,$b,$real,$real,$valve,$valve,$battery)");
+        $db->query("UPDATE $t SET n=n+1,"
+            ."real_min=min(real_min,$real),real_max=max(real_max,$real),real_sum=real_sum+$real,"
+            ."wanted_sum=wanted_sum+$wanted,"
+            ."valve_min=min(valve_min,$valve),valve_max=max(valve_max,$valve),valve_sum=valve_sum+$valve,"
+            ."battery_min=min(battery_min,$battery),window_sum=window_sum+$window"
+            ." WHERE addr=$addr AND time=$b");
+    }
+}
+
+// delete old data, 0 = keep forever
+function rollup_retention($db,$log_days,$hourly_days,$daily_days) {
+    $now = time();
+    if ($log_days>0) $db->query("DELETE FROM log WHERE time<".($now-$log_days*86400));
+    if ($hourly_days>0) $db->query("DELETE FROM log_hourly WHERE time<".($now-$hourly_days*86400));
+    if ($daily_days>0) $db->query("DELETE FROM log_daily WHERE time<".($now-$daily_days*86400));
+}
+
+// rebuild all rollups from log table (upgrade of old database)
+function rollup_rebuild($db) {
+    $db->query("BEGIN TRANSACTION");
+    $db->query("DELETE FROM log_latest");
+    $db->query("DELETE FROM log_hourly");
+    $db->query("DELETE FROM log_daily");
+    $db->query("INSERT INTO log_latest (addr,time,mode,valve,real,wanted,battery,error,window,force)"
+        ." SELECT l.addr,l.time,l.mode,l.valve,l.real,l.wanted,l.battery,l.error,l.window,l.force"
+        ." FROM log l,(SELECT addr,max(time) AS t FROM log GROUP BY addr) m"
+        ." WHERE l.addr=m.addr AND l.time=m.t GROUP BY l.addr");
+    $agg = "count(*),min(real),max(real),total(real),total(wanted),min(valve),max(valve),total(valve),min(battery),total(window)";
+    $cols = "addr,time,n,real_min,real_max,real_sum,wanted_sum,valve_min,valve_max,valve_sum,battery_min,window_sum";
+    $db->query("INSERT INTO log_hourly ($cols) SELECT addr,(time/3600)*3600 AS b,$agg FROM log GROUP BY addr,b");
+    // local day is computed by PHP, sqlite 'localtime' may use other timezone than $TIMEZONE
+    $result = $db->query("SELECT min(time) AS f,max(time) AS l FROM log");
+    $row = $result->fetchArray();
+    if ($row && $row['f']) {
+        for ($d=rollup_day($row['f']); $d<=$row['l']; $d=rollup_day($d+36*3600)) {
+            $e = rollup_day($d+36*3600);
+            $db->query("INSERT INTO log_daily ($cols) SELECT addr,$d,$agg FROM log"
+                ." WHERE time>=$d AND time<$e GROUP BY addr");
+        }
+    }
+    $db->query("COMMIT");
+}
@@ -0,0 +1,16 @@
+<?php
+
+// create rollup tables in old database and fill them from log table
+// run it once with stopped daemon
+
+$TIMEZONE="Europe/Warsaw";
+date_default_timezone_set($TIMEZONE);
+
+include_once "rollup.php";
+
+$db = new SQLite3("/tmp/openhr20.sqlite");
+$db->query("PRAGMA synchronous=OFF");
+
+rollup_create($db);
+rollup_rebuild($db);
+echo "done!\n";
@@ -9,7 +9,7 @@ if ($hours<=0) $hours=24;
 $now = time();
 $min_time = $now-$hours*60*60;
 
-include 'config.php';
+include 'common.php';
 include 'lib/xy_chart.php';
 
 $g = new XY_chart(600,300);
@@ -28,7 +28,7 @@ $g->x_title='seconds in past';
 $g->yl_title='T [C]';
 $g->yr_title='V [%]';
 
-$result = $db->query("SELECT * FROM log WHERE addr=$addr AND time>$min_time ORDER BY time DESC");
+$result = log_chart_query($addr,$min_time,"DESC");
 
 while ($row = $result->fetchArray()) {
     if ($real) $g->add(0,$row['time']-$now,$row['real']/100);
@@ -7,6 +7,19 @@ function format_time($timestamp) {
     return date("Y-m-d H:i:s",$timestamp);
 }
 
+// rows with time,real,wanted,valve,window for charts
+// raw log for short period, hourly averages (log_hourly) for long period
+function log_chart_query($addr,$min_time,$order='') {
+  global $db,$chart_raw_hours;
+  if (time()-$min_time > $chart_raw_hours*3600) {
+    return $db->query("SELECT time+1800 AS time,real_sum/n AS real,wanted_sum/n AS wanted,"
+      ."valve_sum/n AS valve,(window_sum*2>=n) AS window FROM log_hourly"
+      ." WHERE addr=$addr AND time>$min_time AND n>0 ORDER BY time $order");
+  }
+  return $db->query("SELECT time,real,wanted,valve,window FROM log"
+    ." WHERE addr=$addr AND time>$min_time ORDER BY time $order");
+}
+
 function cleanString($wild) {
     return preg_replace("/[^[_:alnum:]+]/","",$wild);
 }
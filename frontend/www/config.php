@@ -74,6 +74,8 @@ $RRD_DAYS = array (3, 7, 30, 90);
 
   $chart_hours = 48; // chart contain values from last 12 hours
 
+  $chart_raw_hours = 48; // longer charts use hourly averages (log_hourly)
+
   $warning_age = 8*60; // maximum data age for warning
 
   $error_age = 20*60; // maximum data age for error
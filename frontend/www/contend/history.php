@@ -9,12 +9,46 @@ class contend_history extends contend {
     if ($limit<=0) $limit=50;
     $offset = (int)($_GET['offset']);
     if ($offset<0) $offset=0;
+    $res = $_GET['res'];
+    if ($res!='hour' && $res!='day') $res='raw';
 	$order=' ORDER BY time DESC';
 
-    $result = $db->query("SELECT * FROM log WHERE addr=$this->addr ORDER BY time DESC LIMIT $offset,$limit");
+    echo "<div>";
+    foreach (array('raw'=>'all records','hour'=>'hourly','day'=>'daily') as $k=>$v) {
+      if ($k==$res) echo " <b>$v</b>";
+      else echo " <a href=\"?page=history&addr=$this->addr&res=$k&limit=$limit\">$v</a>";
+    }
+    echo "</div>";
+
+    if ($offset>0) echo "<a href=\"?page=history&addr=$this->addr&res=$res&offset=".($offset-$limit)."&limit=$limit\">previous $limit</a>";
+    echo " <a href=\"?page=history&addr=$this->addr&res=$res&offset=".($offset+$limit)."&limit=$limit\">next $limit</a>";
+
+    if ($res!='raw') {
+      $table = ($res=='hour')?'log_hourly':'log_daily';
+      $result = $db->query("SELECT * FROM $table WHERE addr=$this->addr AND n>0$order LIMIT $offset,$limit");
+      echo "<table>\n";
+      echo "<tr><th>time</th><th>records</th><th>real min</th><th>real avg</th><th>real max</th>";
+      echo "<th>wanted avg</th><th>valve min</th><th>valve avg</th><th>valve max</th>";
+      echo "<th>battery min</th><th>window [%]</th></tr>";
+      while ($row = $result->fetchArray()) {
+	$n=$row['n'];
+	echo "<tr><td>".format_time($row['time'])."</td>";
+	echo "<td>".$n."</td>";
+	echo "<td>".($row['real_min']/100)."</td>";
+	echo "<td>".round($row['real_sum']/$n/100,2)."</td>";
+	echo "<td>".($row['real_max']/100)."</td>";
+	echo "<td>".round($row['wanted_sum']/$n/100,2)."</td>";
+	echo "<td>".$row['valve_min']."</td>";
+	echo "<td>".round($row['valve_sum']/$n)."</td>";
+	echo "<td>".$row['valve_max']."</td>";
+	echo "<td>".($row['battery_min']/1000)."</td>";
+	echo "<td>".round($row['window_sum']*100/$n)."</td></tr>";
+      }
+      echo "</table>\n";
+      return;
+    }
 
-    if ($offset>0) echo "<a href=\"?page=history&addr=$this->addr&offset=".($offset-$limit)."&limit=$limit\">previous $limit</a>";
-    echo " <a href=\"?page=history&addr=$this->addr&offset=".($offset+$limit)."&limit=$limit\">next $limit</a>";
+    $result = $db->query("SELECT * FROM log WHERE addr=$this->addr$order LIMIT $offset,$limit");
 
     echo "<table>\n";
     echo "<tr><th>time</th><th>mode</th><th>valve</th><th>real</th><th>wanted</th><th>battery</th>";
@@ -50,9 +50,22 @@ class contend_queue extends contend {
 	}	
       }
 
+      // watch trace ring (Z/J), hr20gw queues next J itself
+      if ($_GET['stream_trace']==1) {
+	$mask = isset($_GET['mask']) ? hexdec($_GET['mask']) & 0xffff : 0x00a7;
+	$cmd[] = sprintf ("Zff%04x",$mask);
+	$cmd[] = "J00";
+      }
+
+      if ($_GET['stream_trace']=='0') {
+	$cmd[] = "Z000000";
+      }
+
       if ($_GET['read_info']==1) {
 	$cmd[] = "D";
 	$cmd[] = "V";
+	$cmd[] = "Tff";	// trace layout and battery life, see status
+	$cmd[] = "T0d";
       }
 
       return $cmd;
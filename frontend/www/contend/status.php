@@ -8,7 +8,7 @@ class contend_status extends contend {
     global $db,$room_name;
     $cmd=null;
     if ($_POST['type'] == 'addr') {
-      $result = $db->query("SELECT * FROM log WHERE addr=$this->addr ORDER BY TIME DESC LIMIT 1");
+      $result = $db->query("SELECT * FROM log_latest WHERE addr=$this->addr");
       // foreach ($_POST as $k=>$p) echo "<div>$k => $p</div>";
       if ($row = $result->fetchArray()) {
 	if ((isset($_POST['auto_mode']) && ($row['mode']!=$_POST['auto_mode']))) {
@@ -30,7 +30,7 @@ class contend_status extends contend {
       }  
     } else if ($_POST['type'] == 'all') {
       foreach ($room_name as $k=>$v) {
-	$result = $db->query("SELECT * FROM log WHERE addr=$k ORDER BY time DESC LIMIT 1");
+	$result = $db->query("SELECT * FROM log_latest WHERE addr=$k");
 	if ($row = $result->fetchArray()) {
 	  if ((isset($_POST["auto_mode_$k"]) && ($row['mode']!=$_POST["auto_mode_$k"]))) {
 	    switch ($_POST["auto_mode_$k"]) {
@@ -53,12 +53,22 @@ class contend_status extends contend {
     }
     return $cmd;
   }  
+
+  // projected battery life is watch 0x0d of trace layout 07/87, requested by "T0d"
+  private function battery_days($addr) {
+    global $db;
+    $result = $db->query("SELECT idx,value FROM trace WHERE addr=$addr AND idx IN (13,255)");
+    $v = array();
+    while ($row = $result->fetchArray()) $v[$row['idx']] = $row['value'];
+    if (!isset($v[255]) || (($v[255] & 0x7f) != 0x07) || !isset($v[13]) || ($v[13] == 0xffff)) return null;
+    return $v[13];
+  }
   
   public function view() {
     global $db,$room_name,$chart_hours;
     if ($this->addr > 0) {
       echo ('<div><a href="?page=queue&read_info=1&addr='.$this->addr.'">Make refresh requests for all values</a></div>');
-      $result = $db->query("SELECT * FROM log WHERE addr=$this->addr ORDER BY time DESC LIMIT 1");
+      $result = $db->query("SELECT * FROM log_latest WHERE addr=$this->addr");
 
       if ($row = $result->fetchArray()) {
 	echo '<form method="post" action="?page=status&amp;addr='.$this->addr.'" />';
@@ -73,6 +83,8 @@ class contend_status extends contend {
 	echo   '<input type="text" name="w_temp" maxlength="5" size="6" value="'.($row['wanted']/100).'" />&deg;C';
 	echo '</div>';
 	echo "<div>Battery: ".($row['battery']/1000)."V</div>";
+	$days = $this->battery_days($this->addr);
+	if ($days!==null) echo "<div>Battery life: ".$days." days</div>";
 	if ($row['error']) echo "<div>error:".$row['error']."</div>";
 	echo "<div>Window: ".(($row['window'])?"open":"close")."</div>";
 	echo '<input type="hidden" name="type" value="addr">';
@@ -94,7 +106,7 @@ class contend_status extends contend {
 	    $now = time();
 	    $min_time = $now-$chart_hours*60*60;
 	    
-	    $result = $db->query("SELECT * FROM log WHERE addr=$this->addr AND time>$min_time ORDER BY time");    
+	    $result = log_chart_query($this->addr,$min_time);
 	    $real=array();$wanted=array();$valve=array();$markings=array();
 	    $off=date_offset_get(new DateTime);
 	    $window=-1; $win_pos=0;
@@ -201,7 +213,7 @@ class contend_status extends contend {
 	echo '<tr><th>valve</th><th>Last update</th><th>Mode</th><th>Valve [%]</th><th>Real [&deg;C]</th>'
 	    .'<th>Wanted [&deg;C]</th><th>Battery</th><th>Error</th><th>Window</th></tr>';
 	foreach ($room_name as $k=>$v) {
-	  $result = $db->query("SELECT * FROM log WHERE addr=$k ORDER BY time DESC LIMIT 1");
+	  $result = $db->query("SELECT * FROM log_latest WHERE addr=$k");
 	  echo "<tr><td><a href=\"?page=status&amp;addr=$k\">$v</a></td>";
 	  if ($row = $result->fetchArray()) {
 	    $age=time()-$row['time'];
@@ -226,7 +238,8 @@ class contend_status extends contend {
       } else {
         $bat_c = ''; 
       }
-	    echo "<td$bat_c>".($row['battery']/1000)."V</td>";
+	    echo "<td$bat_c>".($row['battery']/1000)."V"
+		.((($days = $this->battery_days($k))!==null)?"<br />".$days." days":"")."</td>";
 	    echo "<td".((($row['error'])&$GLOBALS['error_show'])?' class="error"':'').">";
 	      $errs=0;
         foreach ($GLOBALS['error_mask'] as $k=>$v) {
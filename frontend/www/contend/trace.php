@@ -12,6 +12,8 @@ class contend_trace extends contend {
 
     $result = $db->query("SELECT * FROM trace WHERE addr=$this->addr ORDER BY idx");
     echo ('<div><a href="?page=queue&read_trace=1&addr='.$this->addr.'">Make refresh requests for all values</a></div>');
+    echo ('<div><a href="?page=queue&stream_trace=1&addr='.$this->addr.'">Stream values on every PID step</a>'
+	.' / <a href="?page=queue&stream_trace=0&addr='.$this->addr.'">stop</a> (needs hr20gw)</div>');
     echo ('<table><tr><th>name</th><th>idx</th><th>value</th><th>last_update</th><th>description</th></tr>');  
     while ($row = $result->fetchArray()) {
 	printf("<tr><td>%s</td><td>0x%02x</td><td>0x%04x</td><td>%s</td><td>%s</td></tr>\n"
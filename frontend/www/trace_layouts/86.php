@@ -0,0 +1,24 @@
+<?php
+
+$trace_layout_ids_double = array (
+    array( 'sumError_LO_W' , '' ),
+    array( 'sumError_HI_W' , '' ),
+    array( 'CTL_interatorCredit', ''),
+    array( 'CTL_creditExpiration', ''),    
+    array( 'CTL_mode_window' , 'Controller mode window timeout (0=closed)' ),
+    array( 'motor_diag' , 'MOTOR diagnostic, time between 2 pulses' ),
+    array( 'MOTOR_PosMax' , 'MOTOR maximum position [pulses]' ),
+    array( 'MOTOR_PosAct' , 'MOTOR actual position [pulses]' ),
+    array( 'MOTOR_PosOvershoot' , 'volume of pulses after last motor stop'),
+    array( 'MOTOR_run_time_LO_W' , 'MOTOR total run time [sec] / lower word' ),
+    array( 'MOTOR_run_time_HI_W' , 'MOTOR total run time [sec] / upper word' ),
+    array( 'MOTOR_starts' , 'count of motor starts' ),
+    array( 'MOTOR_MOTOR_counter_LO_W' , 'volume of motor pulses / diagnostic / lower world' ),
+    array( 'MOTOR_MOTOR_counter_HI_W' , 'volume of motor pulses / diagnostic / upper world' ),
+    0xff => array( 'LAYOUT_VERSION' , '' )
+);
+
+foreach ($trace_layout_ids_double as $k=>$v) {
+  $trace_layout_ids[$k]=$v[0];
+  $trace_layout_names[$v[0]]=$k;
+}
@@ -53,8 +53,8 @@
 
 //Boot section start address(byte)
 //define BootStart to 0 will disable this function
-#define BootStart          0x1E00 * 2
-//#define BootStart          0x1C00 * 2
+//#define BootStart          0x1E00 * 2
+#define BootStart          0x1C00 * 2
 
 //verify flash's data while write
 //ChipCheck will only take effect while BootStart enable also
@@ -114,6 +114,15 @@ unsigned char KEY[] = {0x64};
 //Verbose mode: display more prompt message
 #define VERBOSE            0
 
+//OpenHR20 radio firmware update (ota.c), needs 2kB boot section (BOOTSZ=00)
+#define OTAEn              1
+
+//OpenHR20 streaming update (tools/hr20flash) instead of XMODEM (avrubd.exe)
+//clock is set to 4MHz and RC oscillator calibrated by 32kHz crystal,
+//password and data use STREAMBAUD (double speed mode)
+#define STREAMEn           1
+#define STREAMBAUD         38400
+
 #endif
 
 //End of file: bootcfg.h
@@ -37,6 +37,12 @@
 
 #include "bootcfg.h"
 #include "bootldr.h"
+#if OTAEn
+#include "ota.h"
+#endif
+#if STREAMEn
+#include <util/crc16.h>
+#endif
 
 //user's application start address
 #define PROG_START         0x0000
@@ -67,6 +73,15 @@ unsigned int FlashAddr;
 #endif
 
 
+#if STREAMEn
+//streaming update: page is received into one buffer while other one is written
+unsigned char sbuf[2][SPM_PAGESIZE];
+unsigned char spage[2];
+unsigned char spend;                           //buffers waiting for flash (bit 0, 1)
+unsigned char sflash;                          //buffer in flash
+unsigned char sstate;                          //0: idle  1: erase  2: write
+#else
+
 //update one Flash page
 void write_one_page(unsigned char *buf)
 {
@@ -79,6 +94,7 @@ void write_one_page(unsigned char *buf)
   boot_page_write(FlashAddr);                  //write buffer to one Flash page
   boot_spm_busy_wait();                        //wait Flash page write finish
 }
+#endif
 
 //jump to user's application
 void quit()
@@ -121,6 +137,192 @@ void putstr(const char *str)
 }
 #endif
 
+#if STREAMEn
+//calibrate RC oscillator by 32kHz crystal, same as calibrate_rco() of application
+//timer2 keeps running, application sets it up again
+#define EXTERNAL_TICKS     200
+#define XTAL_FREQUENCY     32768
+#define LOOP_CYCLES        7
+#define RCO_COUNT          ((EXTERNAL_TICKS * F_CPU) / (XTAL_FREQUENCY * LOOP_CYCLES))
+
+void rco_calibrate(void)
+{
+  unsigned char cycles = 0x80;
+  unsigned int count;
+
+  ASSR = (1 << AS2);
+  TCCR2A = (1 << CS20);
+  do
+  {
+    count = 0;
+    TCNT2 = 0;
+    while(ASSR & ((1 << OCR2UB) | (1 << TCN2UB) | (1 << TCR2UB)));
+    //this loop needs to take exactly LOOP_CYCLES CPU cycles
+    do
+    {
+      count++;
+    }
+    while(TCNT2 < EXTERNAL_TICKS);
+    if(count > RCO_COUNT)
+      OSCCAL--;
+    else if(count < RCO_COUNT)
+      OSCCAL++;
+    else
+      break;
+  }
+  while(--cycles);
+}
+
+//flash state machine, SPM works while bootloader (NRWW section) receives data
+void stream_poll(void)
+{
+  unsigned char i;
+
+  if(boot_spm_busy())
+    return;
+  if(sstate == 1)                              //erase done, write page
+  {
+    for(i = 0; i < SPM_PAGESIZE; i += 2)
+      boot_page_fill(i, sbuf[sflash][i] + (sbuf[sflash][i + 1] << 8));
+    boot_page_write((unsigned int)spage[sflash] * SPM_PAGESIZE);
+    sstate = 2;
+    return;
+  }
+  if(sstate == 2)                              //write done
+  {
+    boot_rww_enable();
+    spend &= ~(1 << sflash);
+    sstate = 0;
+  }
+  if(spend)                                    //erase next page
+  {
+    sflash = (spend & 1) ? 0 : 1;
+    boot_page_erase((unsigned int)spage[sflash] * SPM_PAGESIZE);
+    sstate = 1;
+  }
+}
+
+//wait until all received pages are written
+void stream_flush(void)
+{
+  while(spend || sstate)
+    stream_poll();
+}
+
+//receive a byte, flash is written meanwhile
+//no data for TimeOutCntC * timeclk: finish flash and start application
+unsigned char stream_get(void)
+{
+  unsigned char cnt = TimeOutCntC;
+
+  while(!DataInCom())
+  {
+    stream_poll();
+#if WDGEn
+    wdt_reset();
+#endif
+    if(TIFRREG & (1 << OCF1A))
+    {
+      TIFRREG |= (1 << OCF1A);
+      if(--cnt == 0)
+      {
+        stream_flush();
+        quit();
+      }
+    }
+  }
+  return ReadCom();
+}
+
+//drop rest of stream after error, until host stops sending for one timer interval
+void stream_drain(void)
+{
+  TCNT1 = 0;
+  TIFRREG |= (1 << OCF1A);
+  while(!(TIFRREG & (1 << OCF1A)))
+  {
+    stream_poll();
+    if(DataInCom())
+    {
+      ReadCom();
+      TCNT1 = 0;
+    }
+  }
+}
+
+//streaming update, host side is tools/hr20flash
+//host sends pages without waiting for answers, every page has its own CRC16,
+//CRC of all pages lets host skip pages already written (resume)
+void stream_run(void)
+{
+  unsigned char k, p, i;
+  unsigned int crc;
+
+  k = 0;
+  while(1)
+  {
+    switch(stream_get())
+    {
+    case STREAM_HELLO:                         //also after restart of host
+      WriteCom(STREAM_HELLO);
+      WriteCom(BootStart / SPM_PAGESIZE);
+      break;
+
+    case STREAM_CRC:
+      stream_flush();
+      WriteCom(STREAM_CRC);
+      for(FlashAddr = 0; FlashAddr < BootStart; )
+      {
+        crc = 0;
+        for(i = 0; i < SPM_PAGESIZE; i++)
+          crc = _crc_xmodem_update(crc, pgm_read_byte(FlashAddr++));
+        WriteCom(crc >> 8);
+        WriteCom(crc & 0xff);
+      }
+      break;
+
+    case STREAM_PAGE:
+      while(spend & (1 << k))                  //buffer still waits for flash
+        stream_poll();
+      p = stream_get();
+      crc = _crc_xmodem_update(0, p);
+      for(i = 0; i < SPM_PAGESIZE; i++)
+      {
+        sbuf[k][i] = stream_get();
+        crc = _crc_xmodem_update(crc, sbuf[k][i]);
+      }
+      crc ^= (unsigned int)stream_get() << 8;
+      crc ^= stream_get();
+      if((crc == 0) && (p < BootStart / SPM_PAGESIZE))
+      {
+        spage[k] = p;
+        spend |= (1 << k);                     //written in background
+        k ^= 1;
+        WriteCom(STREAM_ACK);
+        WriteCom(p);
+      }
+      else
+      {
+        WriteCom(STREAM_NAK);
+        WriteCom(p);
+        stream_drain();
+      }
+#if LEDEn
+      //LED indicate update status
+      LEDAlt();
+#endif
+      break;
+
+    case STREAM_END:
+      stream_flush();
+      WriteCom(STREAM_END);
+      return;
+    }
+  }
+}
+
+#else
+
 //calculate CRC checksum
 #if BUFSIZE > 255
 void crc16(unsigned char *buf)
@@ -162,12 +364,15 @@ void crc16(unsigned char *buf)
   ch = crc / 256;
   cl = crc % 256;
 }
+#endif
 
 int main(void)
 {
   unsigned char cnt;
+#if !STREAMEn
   unsigned char packNO;
   unsigned char crch, crcl;
+#endif
 
 #if InitDelay > 255
   unsigned int di;
@@ -175,7 +380,8 @@ int main(void)
   unsigned char di;
 #endif
 
-#if BUFFERSIZE > 255
+#if STREAMEn
+#elif BUFFERSIZE > 255
   unsigned int li;
 #else
   unsigned char li;
@@ -184,11 +390,24 @@ int main(void)
   //disable interrupt
   __asm__ __volatile__("cli": : );
 
+#if OTAEn
+  //application reboots by watchdog (command B and F), it stays enabled after reset
+  MCUSR = 0;
+  wdt_disable();
+#endif
+
 #if WDGEn
   //if enable watchdog, setup timeout
   wdt_enable(WDTO_1S);
 #endif
 
+#if STREAMEn
+  //4MHz as application, RC oscillator calibrated for STREAMBAUD
+  CLKPR = (1 << CLKPCE);
+  CLKPR = (1 << CLKPS0);
+  rco_calibrate();
+#endif
+
   //initialize timer1, CTC mode
   TimerInit();
 
@@ -272,6 +491,10 @@ int main(void)
 #if VERBOSE
         //prompt timeout
         putstr(msg2);
+#endif
+#if OTAEn
+        //radio update requested by application
+        ota_run();
 #endif
         //quit bootloader
         quit();
@@ -289,6 +512,10 @@ int main(void)
 
 #endif  //LEVELMODE
 
+#if STREAMEn
+  stream_run();
+#else
+
 #if VERBOSE
   //prompt waiting for data
   putstr(msg3);
@@ -474,6 +701,8 @@ int main(void)
   }
 #endif
 
+#endif  //STREAMEn
+
   //quit boot mode
   quit();
   return 0;
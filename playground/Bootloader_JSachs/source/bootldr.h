@@ -72,12 +72,24 @@
 #endif
 #endif
 
+//streaming mode: calibrated 4MHz clock, comport in double speed mode
+#if STREAMEn
+#if F_CPU != 4000000UL
+#error "STREAMEn sets clock to 4MHz, please set F_CPU = 4000000 in Makefile"
+#endif
+#undef BAUDRATE
+#define BAUDRATE           STREAMBAUD
+#define BAUDDIV            8UL
+#else
+#define BAUDDIV            16UL
+#endif
+
 //calculate baudrate register
-#define BAUDREG            ((unsigned int)((F_CPU * 10) / (16UL * BAUDRATE) - 5) / 10)
+#define BAUDREG            ((unsigned int)((F_CPU * 10) / (BAUDDIV * BAUDRATE) - 5) / 10)
 
 //check baudrate register error
 //mocro below maybe not same in different C compiler
-#define FreqTemp           (16UL * BAUDRATE * (((F_CPU * 10) / (16 * BAUDRATE) + 5)/ 10))
+#define FreqTemp           (BAUDDIV * BAUDRATE * (((F_CPU * 10) / (BAUDDIV * BAUDRATE) + 5)/ 10))
 #if ((FreqTemp * 50) > (51 * F_CPU) || (FreqTemp * 50) < (49 * F_CPU))
 #error "BaudRate error > 2% ! Please check BaudRate and F_CPU value."
 #endif
@@ -98,6 +110,7 @@
 #define DDRREG(No)         CONCAT(DDR, No)
 #define TXCBIT(No)         CONCAT(TXC, No)
 #define RXCBIT(No)         CONCAT(RXC, No)
+#define U2XBIT(No)         CONCAT(U2X, No)
 #define RXENBIT(No)        CONCAT(RXEN, No)
 #define TXENBIT(No)        CONCAT(TXEN, No)
 #define URSELBIT(No)       CONCAT(URSEL, No)
@@ -127,6 +140,7 @@
 #define UDR0               UDR
 #define TXC0               TXC
 #define RXC0               RXC
+#define U2X0               U2X
 #define RXEN0              RXEN
 #define TXEN0              TXEN
 #define UCSZ01             UCSZ1
@@ -137,7 +151,7 @@
 //initialize comport
 #define ComInit()                                                         \
         {                                                                 \
-                           UCSRAREG(COMPORTNo) = 0;                       \
+                           UCSRAREG(COMPORTNo) = STREAMEn ? (1 << U2XBIT(COMPORTNo)) : 0; \
                            UCSRBREG(COMPORTNo) = (1 << RXENBIT(COMPORTNo))|(1 << TXENBIT(COMPORTNo)); \
                            UCSRCREG(COMPORTNo) = (1 << USEURSEL)|(1 << UCSZBIT(COMPORTNo, 1))|(1 << UCSZBIT(COMPORTNo, 0));\
                            UBRRHREG(COMPORTNo) = BAUDREG/256;             \
@@ -192,6 +206,14 @@ const char msg5[] = "update fail.";
 #define XMODEM_EOF         0x1A
 #define XMODEM_RWC         'C'
 
+//streaming update command (tools/hr20flash)
+#define STREAM_HELLO       'S'  //'S' -> 'S' pages of application section
+#define STREAM_CRC         'C'  //'C' -> 'C' crc16 of every application page
+#define STREAM_PAGE        'P'  //'P' page data crc16 -> 'A' page or 'N' page
+#define STREAM_ACK         'A'
+#define STREAM_NAK         'N'
+#define STREAM_END         'E'  //'E' -> 'E', application is started
+
 #if RS485
 #define RS485Enable()      PORTREG(RS485PORT) |= (1 << RS485TXEn)
 #define RS485Disable()     PORTREG(RS485PORT) &= ~(1 << RS485TXEn)
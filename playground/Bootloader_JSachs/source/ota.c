@@ -0,0 +1,447 @@
+/*
+
+  Project:       AVR Universal BootLoader, OpenHR20 extension
+  File:          ota.c
+                 radio firmware update, receiver of common/ota.h frames
+
+  Application writes descriptor ee_ota (command F) and reboots. Bootloader
+  keeps RFM12 receiver on, writes received blocks directly to application
+  flash page by page and stores next page to descriptor, update continues
+  after power loss. Image CRC is checked after last page.
+
+  Code is polling only, interrupts are disabled in bootloader.
+  RFM frequency correction (RFM_freqAdjust) is not used here.
+
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/boot.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+
+//RFM12 wiring, same value as RFM_WIRE in src/Makefile
+#if !defined(RFM_WIRE_MARIOJTAG) && !defined(RFM_WIRE_TK_INTERNAL) && !defined(RFM_WIRE_JD_INTERNAL)
+#define RFM_WIRE_JD_INTERNAL 1
+#endif
+#define RFM                1
+
+#include "../../../src/rfm_config.h"
+#include "../../../common/rfm.h"
+#include "../../../common/xtea.h"
+#include "../../../common/ota.h"
+#include "ota.h"
+
+//cancel update request without any received data after this time (seconds)
+#define OTA_IDLE_TMO       600
+//answer queries after successful update (seconds)
+#define OTA_DONE_TMO       3
+
+static const unsigned char ota_header[4] PROGMEM = {0xaa, 0xaa, 0x2d, 0xd4};
+static const unsigned char ota_km_upper[8] PROGMEM = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef};
+static const unsigned char ota_prefix[8] PROGMEM = OTA_MAC_PREFIX;
+
+static unsigned char kmac[16], k1[8], k2[8];
+static unsigned char rxbuf[OTA_FRAME_DATA];
+static unsigned char pagebuf[OTA_PAGE];
+
+//copy of rfm_spi16 from common/rfm.c
+uint16_t rfm_spi16(uint16_t outval)
+{
+  unsigned char i;
+  uint16_t ret = 0;
+
+  RFM_SPI_SELECT;
+  for(i = 16; i != 0; i--)
+  {
+    if(outval & 0x8000)
+      RFM_SPI_MOSI_HIGH;
+    else
+      RFM_SPI_MOSI_LOW;
+    outval <<= 1;
+    RFM_SPI_SCK_HIGH;
+    ret <<= 1;
+    if(RFM_SPI_MISO_GET)
+      ret |= 1;
+    RFM_SPI_SCK_LOW;
+  }
+  RFM_SPI_DESELECT;
+  RFM_SPI_SELECT;                              //SDO indicate FFIT or RGIT
+  return ret;
+}
+
+//same as RFM_init in common/rfm.c, without frequency adjust
+static void ota_rfm_init(void)
+{
+  RFM_SCK_DDR |= _BV(RFM_SCK_BITPOS);
+  RFM_SDI_DDR |= _BV(RFM_SDI_BITPOS);
+  RFM_NSEL_DDR |= _BV(RFM_NSEL_BITPOS);
+  RFM_SDO_DDR &= ~_BV(RFM_SDO_BITPOS);
+
+  RFM_READ_STATUS();
+  RFM_SPI_16(RFM_CONFIG_EL | RFM_CONFIG_EF | RFM_CONFIG_Band(RFM_FREQ_MAIN) | RFM_CONFIG_X_12_0pf);
+  RFM_SPI_16(RFM_FREQUENCY | RFM_FREQ_Band(RFM_FREQ_MAIN)(RFM_FREQ_DEC));
+  RFM_SPI_16(RFM_SET_DATARATE(RFM_BAUD_RATE));
+  RFM_SPI_16(RFM_RX_CONTROL_P20_VDI | RFM_RX_CONTROL_VDI_MED | RFM_RX_CONTROL_BW(RFM_BAUD_RATE) |
+             RFM_RX_CONTROL_GAIN_6 | RFM_RX_CONTROL_RSSI_103);
+  RFM_SPI_16(RFM_DATA_FILTER_DQD(4));
+  RFM_SPI_16(RFM_FIFO_IT(8) | RFM_FIFO_DR);
+  RFM_SPI_16(RFM_AFC_AUTO_VDI | RFM_AFC_RANGE_LIMIT_7_8 | RFM_AFC_EN | RFM_AFC_OE | RFM_AFC_FI);
+  RFM_SPI_16(RFM_TX_CONTROL_MOD(RFM_BAUD_RATE) | RFM_TX_CONTROL_POW_0);
+  RFM_SPI_16(RFM_PLL | RFM_PLL_uC_CLK_10 | RFM_PLL_DELAY_OFF | RFM_PLL_DITHER_OFF | RFM_PLL_BIRATE_LOW);
+}
+
+//64 bit left roll, same as left_roll in common/cmac.c
+static void ota_roll(unsigned char *d, unsigned char *s)
+{
+  unsigned char i, t, c;
+
+  c = s[7] >> 7;
+  for(i = 0; i < 8; i++)
+  {
+    t = s[i];
+    d[i] = (t << 1) | c;
+    c = t >> 7;
+  }
+}
+
+//same keys as crypto_init in common/wireless.c, security_key is next to RFM_devaddr
+static void ota_keys(unsigned char idx)
+{
+  unsigned char km[16];
+  unsigned char i;
+
+  for(i = 0; i < 8; i++)
+    km[i] = eeprom_read_byte((uint8_t *)(OTA_EE_CONFIG + (idx + 1 + i) * 4));
+  memcpy_P(km + 8, ota_km_upper, 8);
+  for(i = 0; i < 16; i++)
+    kmac[i] = 0xc0 + i;
+  xtea_enc(kmac, kmac, km);
+  xtea_enc(kmac + 8, kmac + 8, km);
+  memset(k1, 0, 8);
+  xtea_enc(k1, k1, kmac);
+  ota_roll(k1, k1);
+  ota_roll(k2, k1);
+}
+
+//CMAC with OTA_MAC_PREFIX, same as cmac_calc in common/cmac.c
+static unsigned char ota_mac(unsigned char *m, unsigned char bytes, unsigned char check)
+{
+  unsigned char i, j, x, t;
+  unsigned char c[8];
+  unsigned char *kx;
+
+  memcpy_P(c, ota_prefix, 8);
+  xtea_enc(c, c, kmac);
+  kx = k1;
+  for(i = 0; i < bytes; )
+  {
+    x = i;
+    i += 8;
+    if(i > bytes)
+      kx = k2;
+    for(j = 0; j < 8; j++, x++)
+    {
+      if(x < bytes)
+        t = m[x];
+      else
+        t = (x == bytes) ? 0x80 : 0;
+      if(i >= bytes)
+        t ^= kx[j];
+      c[j] ^= t;
+    }
+    xtea_enc(c, c, kmac);
+  }
+  if(check)
+    return memcmp(m + bytes, c, 4) == 0;
+  memcpy(m + bytes, c, 4);
+  return 1;
+}
+
+//receive one frame to rxbuf
+//return frame length, 0 on timer tick (1 second)
+static unsigned char ota_receive(void)
+{
+  unsigned char pos = 0;
+  unsigned char len = 0;
+
+  RFM_FIFO_OFF();
+  RFM_FIFO_ON();
+  while(1)
+  {
+    if(TIFR1 & (1 << OCF1A))
+    {
+      TIFR1 |= (1 << OCF1A);
+      return 0;
+    }
+    if(RFM_SPI_MISO_GET)
+    {
+      rxbuf[pos++] = RFM_READ_FIFO();
+      if(pos == 1)
+      {
+        len = rxbuf[0] & 0x7f;
+        if(((rxbuf[0] & 0x80) == 0) || (len < OTA_FRAME_QUERY) || (len > OTA_FRAME_DATA))
+        {
+          pos = 0;                             //noise or packet of running devices
+          RFM_FIFO_OFF();
+          RFM_FIFO_ON();
+        }
+      }
+      else if(pos >= len)
+        return len;
+    }
+  }
+}
+
+//send ACK frame, next expected page and block
+static void ota_send(unsigned char addr, unsigned char page, unsigned char blk, unsigned char st)
+{
+  unsigned char f[4 + OTA_FRAME_ACK + 2];
+  unsigned char i;
+
+  RFM_TX_ON_PRE();
+  memcpy_P(f, ota_header, 4);
+  f[4] = OTA_FRAME_ACK | 0x80;
+  f[5] = OTA_MARK;
+  f[6] = addr;
+  f[7] = OTA_CMD_ACK;
+  f[8] = page;
+  f[9] = blk;
+  f[10] = st;
+  ota_mac(f + 5, OTA_FRAME_ACK - 5, 0);
+  f[sizeof(f) - 2] = 0xaa;                     //dummy bytes
+  f[sizeof(f) - 1] = 0xaa;
+  RFM_TX_ON();
+  for(i = 0; i < sizeof(f); i++)
+  {
+    while(!RFM_SPI_MISO_GET);                  //RGIT
+    RFM_WRITE(f[i]);
+  }
+  while(!RFM_SPI_MISO_GET);
+  RFM_RX_ON();
+}
+
+//update one application page from pagebuf, unchanged page is not written
+static void ota_write_page(unsigned char page)
+{
+  unsigned int addr = (unsigned int)page * OTA_PAGE;
+  unsigned char i;
+
+  if(page >= OTA_PAGES_MAX)                    //never touch bootloader
+    return;
+  for(i = 0; i < OTA_PAGE; i++)
+  {
+    if(pgm_read_byte(addr + i) != pagebuf[i])
+      break;
+  }
+  if(i == OTA_PAGE)
+    return;
+  eeprom_busy_wait();
+  boot_page_erase(addr);
+  boot_spm_busy_wait();
+  for(i = 0; i < OTA_PAGE; i += 2)
+    boot_page_fill(addr + i, pagebuf[i] | (pagebuf[i + 1] << 8));
+  boot_page_write(addr);
+  boot_spm_busy_wait();
+  boot_rww_enable();
+}
+
+//check CRC of application
+static unsigned char ota_verify(unsigned char pages, unsigned int crc)
+{
+  unsigned int a;
+  unsigned int c = 0;
+
+  for(a = 0; a < (unsigned int)pages * OTA_PAGE; a++)
+    c = _crc_xmodem_update(c, pgm_read_byte(a));
+  return c == crc;
+}
+
+//patch decoder state, one chunk builds one page in pagebuf
+static unsigned char pstate, pcnt, ppos, ppage;
+static unsigned int paddr;
+
+#define PST_PAGE           0
+#define PST_OP             1
+#define PST_ADDR_H         2
+#define PST_ADDR_L         3
+#define PST_LITERAL        4
+
+//apply one block of patch chunk
+//return 1 when page is complete (rest of block is padding)
+static unsigned char ota_patch(unsigned char *d)
+{
+  unsigned char i, b;
+
+  for(i = 0; i < OTA_BLOCK; i++)
+  {
+    b = d[i];
+    switch(pstate)
+    {
+    case PST_PAGE:
+      ppage = b;
+      ppos = 0;
+      pstate = PST_OP;
+      break;
+    case PST_OP:
+      pcnt = (b & ~OTA_DELTA_COPY) + 1;
+      pstate = (b & OTA_DELTA_COPY) ? PST_ADDR_H : PST_LITERAL;
+      break;
+    case PST_ADDR_H:
+      paddr = b << 8;
+      pstate = PST_ADDR_L;
+      break;
+    case PST_ADDR_L:
+      paddr |= b;
+      while(pcnt && (ppos < OTA_PAGE))
+      {
+        pagebuf[ppos++] = pgm_read_byte(paddr++);
+        pcnt--;
+      }
+      pstate = PST_OP;
+      break;
+    default:
+      pagebuf[ppos++] = b;
+      if(--pcnt == 0)
+        pstate = PST_OP;
+      break;
+    }
+    if(ppos >= OTA_PAGE)
+    {
+      pstate = PST_PAGE;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void ota_run(void)
+{
+  unsigned char addr, pages, page, blk, st, len, dirty, delta, full, last;
+  unsigned int crc, idle, limit;
+  uint8_t *desc = (uint8_t *)OTA_EE_DESC;
+
+  len = eeprom_read_byte(desc);
+  if(len == 0xff)
+    return;
+  addr = eeprom_read_byte((uint8_t *)(OTA_EE_CONFIG + len * 4));
+  ota_keys(len);
+  pages = eeprom_read_byte(desc + 1);
+  delta = pages & OTA_DELTA;
+  pages &= ~OTA_DELTA;
+  crc = (eeprom_read_byte(desc + 2) << 8) | eeprom_read_byte(desc + 3);
+  page = eeprom_read_byte(desc + 4);
+
+  st = OTA_ST_RUN;
+  limit = OTA_IDLE_TMO;
+  dirty = delta ? (page > 1) : (page != 0);   //delta chunk 0 is header only
+  if(dirty && ota_verify(pages, crc))
+  {
+    st = OTA_ST_DONE;                          //power lost after last page
+    limit = OTA_DONE_TMO;
+  }
+  else if(!delta && (page >= pages))
+    page = 0;
+  blk = 0;
+  pstate = PST_PAGE;
+
+  //timer1: 1 second tick
+  OCR1A = (unsigned int)(F_CPU / 1024);
+  TCNT1 = 0;
+  TCCR1B = (1 << WGM12) | (1 << CS12) | (1 << CS10);
+  TIFR1 |= (1 << OCF1A);
+
+  ota_rfm_init();
+  ota_send(addr, page, blk, st | delta);       //announce
+  idle = 0;
+  while(1)
+  {
+    len = ota_receive();
+    if(len == 0)
+    {
+      if((++idle >= limit) && (!dirty || (st == OTA_ST_DONE)))
+        break;
+      continue;
+    }
+    if((rxbuf[1] != OTA_MARK) || (rxbuf[2] != addr) || !ota_mac(rxbuf + 1, len - 5, 1))
+      continue;
+    idle = 0;
+    if((st == OTA_ST_RUN) && (len == OTA_FRAME_DATA) && (rxbuf[3] == OTA_CMD_DATA)
+       && (rxbuf[4] == page) && (rxbuf[5] == blk))
+    {
+      blk++;
+      full = 0;
+      if(delta && (page == 0))
+      {
+        //header chunk, old image must match
+        if(ota_verify(rxbuf[6], (rxbuf[7] << 8) | rxbuf[8]))
+        {
+          page = 1;
+          eeprom_write_byte(desc + 4, page);
+        }
+        else
+        {
+          st = OTA_ST_BASE;
+          delta = 0;
+          eeprom_write_byte(desc + 1, pages);
+        }
+        blk = 0;
+      }
+      else
+      {
+        if(delta)
+          full = ota_patch(rxbuf + 6);
+        else
+        {
+          memcpy(pagebuf + (blk - 1) * OTA_BLOCK, rxbuf + 6, OTA_BLOCK);
+          full = (blk == OTA_BLOCKS_PER_PAGE);
+        }
+      }
+      if(full)
+      {
+        if(delta)
+        {
+          last = ppage & OTA_DELTA_LAST;
+          ota_write_page(ppage & ~OTA_DELTA_LAST);
+        }
+        else
+        {
+          ota_write_page(page);
+          last = (page + 1 == pages);
+        }
+        dirty = 1;
+        blk = 0;
+        page++;
+        eeprom_write_byte(desc + 4, page);
+        if(last)
+        {
+          if(ota_verify(pages, crc))
+          {
+            st = OTA_ST_DONE;
+            limit = OTA_DONE_TMO;
+          }
+          else
+          {
+            st = OTA_ST_CRC;                   //start again as full update, reported once
+            page = 0;
+            delta = 0;
+            eeprom_write_byte(desc + 1, pages);
+            eeprom_write_byte(desc + 4, 0xff);
+          }
+        }
+      }
+    }
+    ota_send(addr, page, blk, st | delta);
+    if((st == OTA_ST_CRC) || (st == OTA_ST_BASE))
+      st = OTA_ST_RUN;
+  }
+
+  eeprom_busy_wait();
+  eeprom_write_byte(desc, 0xff);               //done or cancelled
+  eeprom_busy_wait();
+  RFM_OFF();
+  TCCR1B = 0;
+}
+
+//End of file: ota.c
@@ -0,0 +1,18 @@
+/*
+
+  Project:       AVR Universal BootLoader, OpenHR20 extension
+  File:          ota.h
+                 radio firmware update, see common/ota.h
+
+*/
+
+#ifndef _OTA_H_
+#define _OTA_H_        1
+
+//receive application over RFM12 if application requested it (command F)
+//return when update is done or cancelled, flash is verified
+void ota_run(void);
+
+#endif
+
+//End of file: ota.h
@@ -44,9 +44,14 @@
 #include "common/uart.h"
 #include "common/rtc.h"
 #include "common/wireless.h"
+#include "common/protocol.h"
 #include "task.h"
 #include "eeprom.h"
 #include "queue.h"
+#include "link.h"
+#if OTA_UPDATE
+#include "common/ota.h"
+#endif
 
 
 #if defined(_AVR_IOM32_H_) || defined(__AVR_ATmega328P__)
@@ -69,6 +74,15 @@ static uint8_t tx_buff_out = 0;
 static uint8_t rx_buff_in = 0;
 static uint8_t rx_buff_out = 0;
 
+/*!
+ *******************************************************************************
+ *  \brief binary dump mode, 0 = text (default), 1 = binary records
+ *
+ *  \note set by "Xmm" command, it is not stored in eeprom. Gateway must
+ *         switch it on after each master reset.
+ ******************************************************************************/
+static uint8_t COM_binary_mode = 0;
+
 extern uint8_t onsync;
 
 /*!
@@ -440,6 +454,13 @@ static void print_incomplete_mark(int8_t len)
  *  \note   D\n - print status line
  *  \note   Yyymmdd\n - set, year yy, month mm, day dd; HEX values!!!
  *  \note   HhhmmSSss\n - set, hour hh, minute mm, second SS, 1/100 second ss; HEX values!!!
+ *  \note   Xmm\n - packet dump mode, mm=00 text, mm=01 binary records (see COM_dump_binary)
+ *  \note   Faappbb<32 hex>\n - send firmware update block bb of page pp to bootloader of slave aa
+ *  \note   Qaa\n - ask bootloader of slave aa for update state
+ *  \note   answer of bootloader is line OTA(aa) ppbbss (next page, block, status see to common/ota.h)
+ *  \note   Laa\n - print radio link statistic of slave aa, aa=ff clear all
+ *  \note   answer L[aa]=rrrr eeee mmmm ssss ff - packets, CMAC errors, missed forced slots,
+ *  \note   packets with RSSI flag, average AFC (as AFC in packet dump); aa=00 are frames with unknown address
  *
  ******************************************************************************/
 void COM_commad_parse(void)
@@ -505,6 +526,35 @@ void COM_commad_parse(void)
 			wl_force_addr1 = 0xff;
 			print_s_p(PSTR("OK"));
 			break;
+		case 'L':
+			if (COM_hex_parse(1 * 2, true) != '\0')
+			{
+				break;
+			}
+			if (com_hex[0] == 0xff)
+			{
+				memset(link_stat, 0, sizeof(link_stat));
+				print_s_p(PSTR("OK"));
+				break;
+			}
+			if (com_hex[0] >= LINK_ADDR_MAX)
+			{
+				break;
+			}
+			print_idx(c);
+			{
+				link_stat_t *l = &link_stat[com_hex[0]];
+				print_hexXXXX(l->rx);
+				COM_putchar(' ');
+				print_hexXXXX(l->mac_err);
+				COM_putchar(' ');
+				print_hexXXXX(l->missed);
+				COM_putchar(' ');
+				print_hexXXXX(l->rssi);
+				COM_putchar(' ');
+				print_hexXX(LINK_afc(l));
+			}
+			break;
 #endif
 		case ':': // intel hex for writing eeprom
 			if (COM_hex_parse(4 * 2, false) != '\0')
@@ -591,31 +641,7 @@ void COM_commad_parse(void)
 				break;
 			}
 			uint8_t ch = COM_getchar();
-			uint8_t len = 0;
-			switch (ch)
-			{
-			case 'D':
-			case 'V':
-				len = 0;
-				break;
-			case 'M':
-			case 'A':
-			case 'L':
-			case 'T':
-			case 'G':
-			case 'R':
-				len = 1;
-				break;
-			case 'S':
-			case 'B':
-				len = 2;
-				break;
-			case 'W':
-				len = 3;
-				break;
-			default:
-				break;
-			}
+			uint8_t len = proto_request_len(ch);
 			if (COM_hex_parse(len * 2, true) != '\0')
 			{
 				break;
@@ -630,6 +656,53 @@ void COM_commad_parse(void)
 			print_s_p(PSTR("OK"));
 		}
 		break;
+#if (RFM == 1) && OTA_UPDATE
+		case 'F':
+		case 'Q':
+		{
+			uint8_t frame[5 + OTA_BLOCK];
+			uint8_t len = 3;
+			if (COM_hex_parse(((c == 'F') ? 3 : 1) * 2, (c == 'Q')) != '\0')
+			{
+				break;
+			}
+			frame[0] = OTA_MARK;
+			frame[1] = com_hex[0];
+			frame[2] = OTA_CMD_QUERY;
+			if (c == 'F')
+			{
+				frame[2] = OTA_CMD_DATA;
+				frame[3] = com_hex[1];
+				frame[4] = com_hex[2];
+				for (len = 5; len < 5 + OTA_BLOCK; len++)
+				{
+					if (COM_hex_parse(1 * 2, false) != '\0')
+					{
+						break;
+					}
+					frame[len] = com_hex[0];
+				}
+				if ((len != 5 + OTA_BLOCK) || (COM_getchar() != '\n'))
+				{
+					break;
+				}
+			}
+			if (wirelessSendOta(frame, len))
+			{
+				print_s_p(PSTR("OK"));
+			}
+		}
+		break;
+#endif
+		case 'X':
+			if (COM_hex_parse(1 * 2, true) != '\0')
+			{
+				break;
+			}
+			COM_binary_mode = com_hex[0];
+			print_idx(c);
+			print_hexXX(COM_binary_mode);
+			break;
 		case 'B':
 		{
 			if (COM_hex_parse(2 * 2, true) != '\0')
@@ -668,10 +741,74 @@ void COM_commad_parse(void)
  *  \note
  ******************************************************************************/
 static uint16_t seq = 0;
+
+/*!
+ *******************************************************************************
+ *  \brief put one byte of binary record, escape bytes which can't be sent
+ *
+ *  \note '\0' terminates the tx interrupt, SYNC and ESC are framing bytes
+ ******************************************************************************/
+static uint8_t COM_putbin(uint8_t c, uint8_t sum)
+{
+	if ((c == 0) || (c == COM_BIN_SYNC) || (c == COM_BIN_ESC))
+	{
+		COM_putchar(COM_BIN_ESC);
+		COM_putchar(c ^ COM_BIN_XOR);
+	}
+	else
+	{
+		COM_putchar(c);
+	}
+	return sum + c;
+}
+
+/*!
+ *******************************************************************************
+ *  \brief dump authenticated packet as binary record
+ *
+ *  \note record: SYNC len addr sec s100 seqH seqL afc payload[len-6] sum
+ *  \note sum is 8bit sum of bytes from len to end of payload
+ *  \note payload is forwarded as received (bit 0x80 = reply flag)
+ ******************************************************************************/
+static void COM_dump_binary(uint8_t addr, uint8_t *d, int8_t len)
+{
+	uint8_t sum = 0;
+	uint8_t a = 0;
+
+#if (RFM_TUNING > 0)
+	a = afc;
+	if (a > 0xf)
+	{
+		a |= 0xf0;
+	}
+	a = 0 - a;
+#endif
+	COM_putchar(COM_BIN_SYNC);
+	sum = COM_putbin(len + COM_BIN_HEADER, sum);
+	sum = COM_putbin(addr, sum);
+	sum = COM_putbin(RTC_GetSecond(), sum);
+	sum = COM_putbin(RTC_s100, sum);
+	sum = COM_putbin(seq >> 8, sum);
+	sum = COM_putbin(seq & 0xff, sum);
+	sum = COM_putbin(a, sum);
+	seq++;
+	while ((len--) > 0)
+	{
+		sum = COM_putbin(*(d++), sum);
+	}
+	COM_putbin(sum, 0);
+	COM_flush();
+}
+
 void COM_dump_packet(uint8_t *d, int8_t len, bool mac_ok)
 {
 	uint8_t addr = d[1];
 
+	if (COM_binary_mode && mac_ok && (len >= (2 + 4)))
+	{
+		COM_dump_binary(addr, d + 2, len - 6); // mac is correct and not needed
+		return;
+	}
 	COM_putchar('@');
 	print_decXX(RTC_GetSecond());
 	COM_putchar('.');
@@ -735,7 +872,10 @@ void COM_dump_packet(uint8_t *d, int8_t len, bool mac_ok)
 
 	while (len > 0)
 	{
-		if (d[0] & 0x80)
+		int16_t size, i;
+		uint8_t fmt;
+
+		if (d[0] & PROTO_REPLY)
 		{
 			COM_putchar('*');
 		}
@@ -743,120 +883,117 @@ void COM_dump_packet(uint8_t *d, int8_t len, bool mac_ok)
 		{
 			COM_putchar('-');
 		}
-		d[0] &= 0x7f;
-		switch (d[0])
+		d[0] &= ~PROTO_REPLY;
+		size = proto_reply_size(d, len);
+		fmt = proto_reply_format(d[0]);
+		if (fmt == PROTO_FMT_TEXT)
 		{
-		case 'V':
-			while (1)
+			for (i = 0; (i < len) && (d[i] != '\n'); i++)
 			{
-				if ((--len) < 0)
-				{
-					print_incomplete_mark(len);
-					break;
-				}
-				if (*d == '\n')
-				{
-					d++;
-					break;
-				}
-				COM_putchar((*d++) & 0x7f);
+				COM_putchar(d[i] & 0x7f);
 			}
-			break;
-		case 'D':
-		case 'A':
-		case 'M':
+		}
+		else if (fmt != PROTO_FMT_RAW)
+		{
 			COM_putchar(d[0]);
-			len -= 10;
-			if (len < 0)
-			{
-				print_incomplete_mark(len);
-				break;
-			}
+		}
+		len -= size;
+		if (len < 0)
+		{
+			print_incomplete_mark(len);
+			break;
+		}
+		switch (fmt)
+		{
+		case PROTO_FMT_STATUS:
 			print_s_p(PSTR(" m"));
-			print_decXX(d[1] & 0x3f);
+			print_decXX(d[PROTO_STATUS_MIN] & PROTO_STATUS_TIME_MASK);
 			print_s_p(PSTR(" s"));
-			print_decXX(d[2] & 0x3f);
+			print_decXX(d[PROTO_STATUS_SEC] & PROTO_STATUS_TIME_MASK);
 			COM_putchar(' ');
-			COM_putchar(((d[1] & 0x80) != 0) ? ((d[1] & 0x40) ? 'A' : '-') : 'M');
+			COM_putchar(((d[PROTO_STATUS_MIN] & PROTO_STATUS_MODE_AUTO) != 0) ?
+				    ((d[PROTO_STATUS_MIN] & PROTO_STATUS_TEST_AUTO) ? 'A' : '-') : 'M');
 			print_s_p(PSTR(" V"));
-			print_decXX(d[9]);
+			print_decXX(d[PROTO_STATUS_VALVE]);
 			print_s_p(PSTR(" I"));
-			print_decXXXX(((uint16_t)d[4] << 8) | d[5]);
+			print_decXXXX(proto_word(d, PROTO_STATUS_TEMP));
 			print_s_p(PSTR(" S"));
-			print_decXXXX(calc_temp(d[8]));
+			print_decXXXX(calc_temp(d[PROTO_STATUS_WANTED]));
 			print_s_p(PSTR(" B"));
-			print_decXXXX(((uint16_t)d[6] << 8) | d[7]);
+			print_decXXXX(proto_word(d, PROTO_STATUS_BAT));
 			print_s_p(PSTR(" E"));
-			print_hexXX(d[3]);
-			if ((d[2] & 0x40) != 0)
+			print_hexXX(d[PROTO_STATUS_ERROR]);
+			if ((d[PROTO_STATUS_SEC] & PROTO_STATUS_WINDOW) != 0)
 			{
 				print_s_p(PSTR(" W"));
 			}
-			if ((d[2] & 0x80) != 0)
+			if ((d[PROTO_STATUS_SEC] & PROTO_STATUS_LOCKED) != 0)
 			{
 				print_s_p(PSTR(" L"));
 			}
-			d += 10;
 			break;
-		case 'T':
-		case 'R':
-		case 'W':
-			COM_putchar(d[0]);
-			len -= 4;
-			if (len < 0)
-			{
-				print_incomplete_mark(len);
-				break;
-			}
+		case PROTO_FMT_WORD:
+		case PROTO_FMT_BYTE:
+		case PROTO_FMT_PROFILE:
+		case PROTO_FMT_TRACE:
+			// X[ii]=value, all bytes after index in hex
 			COM_putchar('[');
 			print_hexXX(d[1]);
 			COM_putchar(']');
 			COM_putchar('=');
-			print_hexXX(d[2]);
-			print_hexXX(d[3]);
-			d += 4;
-			break;
-		case 'G':
-		case 'S':
-			COM_putchar(d[0]);
-			len -= 3;
-			if (len < 0)
+			for (i = (fmt == PROTO_FMT_TRACE) ? (PROTO_TRACE_LEN + 1) : 2; i < size; i++)
 			{
-				print_incomplete_mark(len);
-				break;
+				print_hexXX(d[i]);
 			}
-			COM_putchar('[');
-			print_hexXX(d[1]);
-			COM_putchar(']');
-			COM_putchar('=');
-			print_hexXX(d[2]);
-			d += 3;
 			break;
-		case 'L':
-			COM_putchar(d[0]);
-			len -= 2;
-			if (len < 0)
-			{
-				print_incomplete_mark(len);
-				break;
-			}
+		case PROTO_FMT_VALUE:
 			print_hexXX(d[1]);
-			d += 2;
+			break;
+		case PROTO_FMT_TEXT:
 			break;
 		default:
-			while ((len--) > 0)
+			for (i = 0; i < size; i++)
 			{
 				COM_putchar(' ');
-				print_hexXX(*(d++));
+				print_hexXX(d[i]);
 			}
 			break;
 		}
+		d += size;
 		COM_putchar('\n');
 	}
 	print_s_p(PSTR("}\n"));
 	COM_flush();
 }
 
+#if (RFM == 1) && OTA_UPDATE
+/*!
+ *******************************************************************************
+ *  \brief print answer of slave bootloader
+ *
+ *  \note line OTA(aa) ppbbss, next expected page and block, status
+ ******************************************************************************/
+void COM_print_ota(uint8_t *d, int8_t len, bool mac_ok)
+{
+	print_s_p(PSTR("OTA("));
+	print_hexXX(d[0]);
+	COM_putchar(')');
+	if (!mac_ok || (len != OTA_FRAME_ACK - 6) || (d[1] != OTA_CMD_ACK))
+	{
+		print_s_p(PSTR(" ERR\n"));
+	}
+	else
+	{
+		COM_putchar(' ');
+		print_hexXX(d[2]);
+		print_hexXX(d[3]);
+		print_hexXX(d[4]);
+		COM_putchar('\n');
+	}
+	COM_flush();
+}
+#endif
+
 void COM_print_datetime()
 {
 	print_hexXX(RTC_GetDayOfWeek() + 0xd0);
@@ -33,6 +33,12 @@
 
 #pragma once
 
+// binary packet dump framing, see COM_dump_binary
+#define COM_BIN_SYNC 0xa5       //!< start of binary record, never used in text output
+#define COM_BIN_ESC 0xdb        //!< escape char, next byte is XORed with COM_BIN_XOR
+#define COM_BIN_XOR 0x20
+#define COM_BIN_HEADER 6        //!< addr sec s100 seqH seqL afc
+
 char COM_tx_char_isr(void);
 
 void COM_rx_char_isr(char c);
@@ -41,6 +47,10 @@ void COM_init(void);
 
 void COM_dump_packet(uint8_t *d, int8_t len, bool mac_ok);
 
+#if OTA_UPDATE
+void COM_print_ota(uint8_t *d, int8_t len, bool mac_ok);
+#endif
+
 void COM_print_datetime(void);
 
 void COM_req_RTC(void);
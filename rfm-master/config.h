@@ -111,6 +111,8 @@
 #define RFM_TUNING             0
 #endif
 
+#define EEPROM_JOURNAL         0 //!< timer_mode journal (\ref ee_journal) is used by slave only
+
 /* compiler compatibility */
 #ifndef ISR_NAKED
 #   define ISR_NAKED      __attribute__((naked))
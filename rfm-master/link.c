@@ -0,0 +1,280 @@
+/*
+ *  Open HR20 - RFM12 master
+ *
+ *  target:     ATmega32 @ 10 MHz in Honnywell Rondostat HR20E master
+ *
+ *  compiler:    WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Dario Carluccio (hr20-at-carluccio-dot-de)
+ *				2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+/*!
+ * \file       link.c
+ * \brief      radio link statistic of slaves
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ *
+ * Counters are updated for every received data frame. AFC and RSSI
+ * are taken from RFM status word read with 6th byte of frame (common/rfm.c).
+ * Slot is expected from slave forced by 'O' or 'P' command, slot without
+ * authenticated packet from this slave is counted as missed.
+ *
+ * With AFC_COMPENSATION master corrects RFM_freqAdjust of slave when
+ * average AFC is out of LINK_AFC_LIMIT. Correcting 'S' (or 'G' when value
+ * is unknown) is pushed into queue bank of reply to current packet, slave
+ * applies it immediately. Replies 'G' / 'S' of PROTO_CONFIG_FREQ_ADJUST
+ * from slave (also for host commands) keep value known.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+// HR20 Project includes
+#include "config.h"
+#include "link.h"
+#include "common/rtc.h"
+#include "common/wireless.h"
+#include "common/protocol.h"
+#include "queue.h"
+
+#if (RFM == 1)
+#include "rfm_config.h"
+#include "common/rfm.h"
+
+link_stat_t link_stat[LINK_ADDR_MAX];
+
+/*!
+ *******************************************************************************
+ *  \brief average AFC correction rounded to AFC steps
+ ******************************************************************************/
+int8_t LINK_afc(const link_stat_t *l)
+{
+	return (l->afc + ((l->afc < 0) ? -LINK_AFC_SCALE / 2 : LINK_AFC_SCALE / 2)) / LINK_AFC_SCALE;
+}
+
+static uint8_t link_slot = 0;   //!< slave expected in current second, 0 = none
+static bool link_slot_rx = false;
+
+#if AFC_COMPENSATION
+static uint8_t *link_q = NULL;  //!< correction in queue, it is sent once
+
+/*!
+ *******************************************************************************
+ *  \brief put command into queue bank of reply to current packet
+ *
+ *  \note only into empty bank, reply of slave must fit into frame
+ ******************************************************************************/
+static uint8_t *LINK_push(uint8_t len, uint8_t addr)
+{
+	if ((link_q != NULL) || (Q_get(addr, wl_packet_bank, 0) != NULL))
+	{
+		return NULL;
+	}
+	link_q = Q_push(len, addr, wl_packet_bank);
+	return link_q;
+}
+
+/*!
+ *******************************************************************************
+ *  \brief take RFM_freqAdjust of slave from replies in packet
+ *
+ *  \param *d decrypted payload
+ ******************************************************************************/
+static void LINK_replies(link_stat_t *l, uint8_t *d, int8_t len)
+{
+	while (len > 0)
+	{
+		int16_t size = proto_reply_size(d, len);
+		if (size > len)
+		{
+			break;
+		}
+		if ((size == 3) && (d[1] == PROTO_CONFIG_FREQ_ADJUST)
+		    && (l->adjust_state != LINK_ADJUST_OFF))
+		{
+			if (d[0] == ('S' | PROTO_REPLY))
+			{
+				if ((l->adjust_state == LINK_ADJUST_WRITTEN) && ((int8_t)d[2] != l->adjust))
+				{
+					l->adjust_state = LINK_ADJUST_OFF;
+					break;
+				}
+				l->adjust = d[2];
+				l->adjust_state = LINK_ADJUST_KNOWN;
+			}
+			else if (d[0] == ('G' | PROTO_REPLY))
+			{
+				l->adjust = d[2];
+				l->adjust_state = LINK_ADJUST_KNOWN;
+			}
+		}
+		d += size;
+		len -= size;
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  \brief push correction of slave frequency into queue
+ *
+ *  \note called with reply bank of current packet
+ ******************************************************************************/
+static void LINK_compensate(link_stat_t *l, uint8_t addr)
+{
+	int8_t corr;
+	uint8_t *q;
+
+	if ((l->afc_n < LINK_AFC_SAMPLES) || (l->adjust_state == LINK_ADJUST_OFF))
+	{
+		return;
+	}
+	corr = LINK_afc(l);
+	if ((corr > -LINK_AFC_LIMIT) && (corr < LINK_AFC_LIMIT))
+	{
+		return;
+	}
+	if (l->adjust_state != LINK_ADJUST_KNOWN)
+	{
+		q = LINK_push(2, addr);
+		if (q != NULL)
+		{
+			q[0] = 'G';
+			q[1] = PROTO_CONFIG_FREQ_ADJUST;
+		}
+		return;
+	}
+	if (((corr > 0) && (l->adjust > INT8_MAX - corr))
+	    || ((corr < 0) && (l->adjust < INT8_MIN - corr)))
+	{
+		return;
+	}
+	q = LINK_push(3, addr);
+	if (q != NULL)
+	{
+		l->adjust += corr;
+		l->adjust_state = LINK_ADJUST_WRITTEN;
+		l->afc_n = 0;   // new average with new frequency
+		q[0] = 'S';
+		q[1] = PROTO_CONFIG_FREQ_ADJUST;
+		q[2] = l->adjust;
+	}
+}
+#endif
+
+/*!
+ *******************************************************************************
+ *  \brief count received data frame
+ *
+ *  \param addr address from frame header (not encrypted)
+ *  \param mac_ok CMAC is correct
+ ******************************************************************************/
+void LINK_packet(uint8_t addr, bool mac_ok)
+{
+	link_stat_t *l;
+
+	if (addr >= LINK_ADDR_MAX)
+	{
+		addr = 0;
+	}
+	l = &link_stat[addr];
+	if (!mac_ok)
+	{
+		l->mac_err++;
+		return;
+	}
+	{
+		// AFC offset is 5 bit signed, correction has opposite sign
+		int8_t a = rfm_rx_status & 0x1f;
+		if (a > 0xf)
+		{
+			a -= 0x20;
+		}
+		a = 0 - a;
+		if (l->afc_n == 0)
+		{
+			l->afc = a * LINK_AFC_SCALE;
+		}
+		else
+		{
+			l->afc += (a * LINK_AFC_SCALE - l->afc) / LINK_AFC_WEIGHT;
+		}
+		if (l->afc_n < LINK_AFC_SAMPLES)
+		{
+			l->afc_n++;
+		}
+	}
+	l->rx++;
+	if (rfm_rx_status & RFM_STATUS_RSSI)
+	{
+		l->rssi++;
+	}
+	if (addr == link_slot)
+	{
+		link_slot_rx = true;
+	}
+#if AFC_COMPENSATION
+	if (addr != 0)
+	{
+		LINK_replies(l, rfm_framebuf + 2, rfm_framepos - 6);
+		LINK_compensate(l, addr);
+	}
+#endif
+}
+
+/*!
+ *******************************************************************************
+ *  \brief close slot of last second, open next one
+ *
+ *  \note must be called after RTC_AddOneSecond, slaves use same rule in src/main.c
+ ******************************************************************************/
+void LINK_second(void)
+{
+	uint8_t s = RTC_GetSecond();
+
+	if ((link_slot != 0) && !link_slot_rx)
+	{
+		link_stat[link_slot].missed++;
+	}
+#if AFC_COMPENSATION
+	if (link_q != NULL)
+	{
+		Q_drop(link_q);
+		link_q = NULL;
+	}
+#endif
+	link_slot_rx = false;
+	link_slot = 0;
+	if (wl_force_addr1 == 0xff)
+	{
+		s %= 30;
+		if ((wl_force_flags >> s) & 1)
+		{
+			link_slot = s;
+		}
+	}
+	else if ((wl_force_addr1 != 0xfe) && (s > 30))
+	{
+		link_slot = (s & 1) ? wl_force_addr1 : wl_force_addr2;
+	}
+	if (link_slot >= LINK_ADDR_MAX)
+	{
+		link_slot = 0;
+	}
+}
+#endif
@@ -0,0 +1,66 @@
+/*
+ *  Open HR20 - RFM12 master
+ *
+ *  target:     ATmega32 @ 10 MHz in Honnywell Rondostat HR20E master
+ *
+ *  compiler:    WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Dario Carluccio (hr20-at-carluccio-dot-de)
+ *				2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+/*!
+ * \file       link.h
+ * \brief      radio link statistic of slaves
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ */
+
+#pragma once
+
+#define LINK_ADDR_MAX 30        //!< slaves 1..29, index 0 counts frames with other address
+#define LINK_AFC_SCALE 16       //!< unit of AFC average is 1/16 of AFC step
+#define LINK_AFC_WEIGHT 8       //!< new AFC value has weight 1/8 in average
+#define LINK_AFC_SAMPLES 8      //!< packets in average before correction of slave frequency
+#define LINK_AFC_LIMIT 2        //!< AFC steps, smaller offset is not corrected
+
+/* state of slave RFM_freqAdjust (AFC_COMPENSATION) */
+#define LINK_ADJUST_UNKNOWN 0   //!< read it by 'G'
+#define LINK_ADJUST_KNOWN 1
+#define LINK_ADJUST_WRITTEN 2   //!< 'S' is sent, reply must confirm value
+#define LINK_ADJUST_OFF 3       //!< slave does not accept it (built without RFM_TUNING)
+
+typedef struct
+{
+	uint16_t rx;            //!< authenticated packets
+	uint16_t mac_err;       //!< packets with wrong CMAC
+	uint16_t missed;        //!< forced slots without packet
+	uint16_t rssi;          //!< authenticated packets with RSSI flag in RFM status
+	int16_t afc;            //!< average AFC correction, LINK_AFC_SCALE units, sign as AFC in packet dump
+	uint8_t afc_n;          //!< packets in average, up to LINK_AFC_SAMPLES
+#if AFC_COMPENSATION
+	uint8_t adjust_state;   //!< LINK_ADJUST_*
+	int8_t adjust;          //!< RFM_freqAdjust of slave
+#endif
+} link_stat_t;
+
+extern link_stat_t link_stat[LINK_ADDR_MAX];
+
+int8_t LINK_afc(const link_stat_t *l);
+void LINK_packet(uint8_t addr, bool mac_ok);
+void LINK_second(void);
@@ -49,6 +49,7 @@
 #include "task.h"
 #include "eeprom.h"
 #include "queue.h"
+#include "link.h"
 #include "common/rtc.h"
 #include "common/cmac.h"
 #include "common/wireless.h"
@@ -154,6 +155,9 @@ int __attribute__ ((noreturn)) main(void)
 				wl_packet_bank = 0;
 #endif
 				RTC_AddOneSecond();
+#if (RFM == 1)
+				LINK_second();
+#endif
 				bool minute = (RTC_GetSecond() == 0);
 				if (RTC_GetSecond() < 30)
 				{
@@ -191,7 +195,8 @@ int __attribute__ ((noreturn)) main(void)
 					wireless_buf_ptr = 0;
 					wireless_putchar(RTC_GetYearYY());
 					uint8_t d = RTC_GetDay();
-					wireless_putchar((RTC_GetMonth() << 4) + (d >> 3));
+					wireless_putchar((RTC_GetMonth() << 4) + (d >> 3)
+							 + WL_SYNC_DST_VALID + (RTC_IsDST() ? WL_SYNC_DST : 0));
 					wireless_putchar((d << 5) + RTC_GetHour());
 					wireless_putchar((RTC_GetMinute() << 1) + ((RTC_GetSecond() == 30) ? 1 : 0));
 					if (wl_force_addr1 != 0xfe)
@@ -93,6 +93,26 @@ void Q_clean(uint8_t addr_preserve)
 	}
 }
 
+/*!
+ *******************************************************************************
+ *  \brief remove one item, data is pointer returned by Q_push
+ *
+ *  \note call it before \ref Q_clean frees the item, after that the slot
+ *        can belong to other item
+ ******************************************************************************/
+void Q_drop(uint8_t *data)
+{
+	uint8_t i;
+
+	for (i = 0; i < Q_ITEMS; i++)
+	{
+		if (Q_buf[i].data == data)
+		{
+			Q_buf[i].addr = 0;
+		}
+	}
+}
+
 /*!
  *******************************************************************************
  *  \brief get items for addr_bank
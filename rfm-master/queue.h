@@ -48,4 +48,5 @@ typedef struct
 
 uint8_t *Q_push(uint8_t len, uint8_t addr, uint8_t bank);
 void Q_clean(uint8_t addr_preserve);
+void Q_drop(uint8_t *data);
 q_item_t *Q_get(uint8_t addr, uint8_t bank, uint8_t skip);
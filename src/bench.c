@@ -0,0 +1,171 @@
+/*
+ *  Open HR20
+ *
+ *  target:     ATmega169 @ 4 MHz in Honnywell Rondostat HR20E
+ *
+ *  compiler:   WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file       bench.c
+ * \brief      cycle benchmark of hot paths, image for simulator (make bench)
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ */
+
+// AVR LibC includes
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+// HR20 Project includes
+#include "config.h"
+#include "main.h"
+#include "adc.h"
+#include "lcd.h"
+#include "common/rtc.h"
+#include "task.h"
+#include "menu.h"
+#include "com.h"
+#include "common/uart.h"
+#include "controller.h"
+#include "bench.h"
+
+#if RFM
+#include "rfm_config.h"
+#include "common/rfm.h"
+#include "common/wireless.h"
+#include "common/cmac.h"
+#endif
+
+#if BENCH
+
+/*!
+ *******************************************************************************
+ *  wait until serial output is sent, interrupts of it are not measured
+ ******************************************************************************/
+static void bench_idle(void)
+{
+	COM_flush();
+	while (UART_need_clock() & _BV(TXEN0))
+	{
+		;
+	}
+}
+
+// frame of one measured call, interrupts are disabled inside
+#define BENCH_CALL(id, call) \
+	do { \
+		uint8_t bench_i; \
+		for (bench_i = 0; bench_i < BENCH_LOOPS; bench_i++) { \
+			bench_idle(); \
+			cli(); \
+			BENCH_MARK = (id); \
+			call; \
+			BENCH_MARK = 0; \
+			sei(); \
+		} \
+	} while (0)
+
+/*!
+ *******************************************************************************
+ *  wait for ADC conversion started by sleep in application
+ ******************************************************************************/
+static void bench_adc_conversion(void)
+{
+	ADCSRA |= _BV(ADSC);
+	while (ADCSRA & _BV(ADSC))
+	{
+		;
+	}
+	task &= ~TASK_ADC;
+}
+
+/*!
+ *******************************************************************************
+ *  run all paths of BENCH_LIST, BENCH_LOOPS times each
+ *
+ *  \note called from main instead of main loop, simulator stops on BENCH_END
+ ******************************************************************************/
+void BENCH_run(void)
+{
+	uint8_t i;
+
+	BENCH_CALL(1, asm volatile ("nop"));
+	BENCH_CALL(2, CTL_update(false));
+	BENCH_CALL(3, (PID_force_update = 0, CTL_update(false)));
+	for (i = 0; i < BENCH_LOOPS; i++)
+	{
+		bool more;
+		start_task_ADC();
+		do
+		{
+			bench_adc_conversion();
+			bench_idle();
+			cli();
+			BENCH_MARK = 4;
+			more = task_ADC();
+			BENCH_MARK = 0;
+			sei();
+		}
+		while (more);
+	}
+	BENCH_CALL(5, RTC_AddOneSecond());
+#if RFM
+	// full data frame from other device, MAC fails
+	for (i = 0; i < BENCH_LOOPS; i++)
+	{
+		uint8_t j;
+		for (j = 1; j < RFM_FRAME_MAX; j++)
+		{
+			rfm_framebuf[j] = j;
+		}
+		rfm_framebuf[0] = RFM_FRAME_MAX - 1;
+		rfm_framepos = RFM_FRAME_MAX - 1;
+		bench_idle();
+		cli();
+		BENCH_MARK = 6;
+		wirelessReceivePacket();
+		BENCH_MARK = 0;
+		sei();
+	}
+	{
+		uint8_t m[32 + 4];
+		memset(m, 0x5a, sizeof(m));
+		BENCH_CALL(7, cmac_calc(m, 32, NULL, false));
+	}
+#endif
+	// COM_putchar enables interrupts, first UART interrupts are included
+	BENCH_CALL(8, COM_print_debug(0));
+	BENCH_CALL(9, menu_view(true));
+	BENCH_CALL(10, task_lcd_update());
+
+	bench_idle();
+	cli();
+	BENCH_MARK = BENCH_END;
+	for (;; )
+	{
+		sleep_mode();   // interrupts are disabled, simulator stops
+	}
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+ *  Open HR20
+ *
+ *  target:     ATmega169 @ 4 MHz in Honnywell Rondostat HR20E
+ *
+ *  compiler:   WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file       bench.h
+ * \brief      cycle benchmark of hot paths, image for simulator (make bench)
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ *
+ * Every measured call is framed by writes of its id and 0 to BENCH_MARK,
+ * simulator (tools/avrbench) takes cycle counter on these writes.
+ * BENCH_END stops simulation. This header is used also by avrbench.
+ */
+
+#pragma once
+
+#define BENCH_MARK GPIOR2       //!< not used by application, task and display_task use GPIOR0/1
+#define BENCH_MARK_ADDR 0x4b    //!< data address of GPIOR2 on ATmega169/329
+#define BENCH_END 0xff
+#define BENCH_LOOPS 8           //!< calls of every path
+
+/*
+ * X(id, name), id 1 is empty frame, its cycles are subtracted from others
+ */
+#define BENCH_LIST(X) \
+	X(1, empty) \
+	X(2, CTL_update) \
+	X(3, CTL_update_PID) \
+	X(4, task_ADC) \
+	X(5, RTC_AddOneSecond) \
+	X(6, wirelessReceivePacket) \
+	X(7, cmac_calc) \
+	X(8, COM_print_debug) \
+	X(9, menu_view) \
+	X(10, task_lcd_update)
+
+#if BENCH && defined(__AVR__)
+void BENCH_run(void) __attribute__ ((noreturn));
+#endif
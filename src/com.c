@@ -46,15 +46,25 @@
 #include "task.h"
 #include "watch.h"
 #include "eeprom.h"
+#include "motor.h"
 #include "controller.h"
 #include "menu.h"
 #include "common/wireless.h"
+#include "common/protocol.h"
 #include "debug.h"
 
 
 #define TX_BUFF_SIZE 128
 #define RX_BUFF_SIZE 32
 
+// replies must match table in common/protocol.h
+#if DEBUG_MOTOR_PROFILE
+typedef char com_check_profile_t[(sizeof(motor_profile_t) == PROTO_PROFILE_SIZE) ? 1 : -1];
+#endif
+#if DEBUG_WATCH_TRACE
+typedef char com_check_trace_t[(WATCH_TRACE_FETCH <= PROTO_TRACE_MAX) ? 1 : -1];
+#endif
+
 #define ENABLE_LOCAL_COMMANDS 1
 
 static char tx_buff[TX_BUFF_SIZE];
@@ -385,14 +395,15 @@ void COM_print_debug(uint8_t type)
 		wireless_async = true;
 		wireless_putchar('D');
 	}
+	// status record, offsets PROTO_STATUS_* in common/protocol.h
 	wireless_putchar(
 		RTC_GetMinute()
-		| (CTL_test_auto() ? 0x40 : 0)
-		| ((CTL_mode_auto) ? 0x80 : 0));
+		| (CTL_test_auto() ? PROTO_STATUS_TEST_AUTO : 0)
+		| ((CTL_mode_auto) ? PROTO_STATUS_MODE_AUTO : 0));
 	wireless_putchar(
 		RTC_GetSecond()
-		| ((mode_window()) ? 0x40 : 0)
-		| ((menu_locked) ? 0x80 : 0));
+		| ((mode_window()) ? PROTO_STATUS_WINDOW : 0)
+		| ((menu_locked) ? PROTO_STATUS_LOCKED : 0));
 	wireless_putchar(CTL_error);
 	wireless_putchar(temp_average >> 8);    // current temp
 	wireless_putchar(temp_average & 0xff);
@@ -470,7 +481,82 @@ static void print_idx(char t, uint8_t i)
 	COM_putchar('=');
 }
 
+/*!
+ *******************************************************************************
+ *  \brief index of config byte for commands G and S
+ *
+ *  \returns index in config_raw, CONFIG_RAW_SIZE for unknown index
+ ******************************************************************************/
+static uint8_t COM_config_idx(uint8_t idx)
+{
+#if (RFM == 1) && (RFM_TUNING > 0)
+	if (idx == PROTO_CONFIG_FREQ_ADJUST)
+	{
+		return (uint8_t)((uint16_t)&config.RFM_freqAdjust - (uint16_t)&config);
+	}
+#endif
+	return (idx < CONFIG_RAW_SIZE) ? idx : CONFIG_RAW_SIZE;
+}
 
+/*!
+ *******************************************************************************
+ *  \brief command S, write config byte
+ *
+ *  \note RFM frequency is changed immediately, master corrects it by AFC
+ ******************************************************************************/
+static void COM_config_write(uint8_t idx, uint8_t value)
+{
+	idx = COM_config_idx(idx);
+	if (idx < CONFIG_RAW_SIZE)
+	{
+		config_raw[idx] = value;
+		eeprom_config_save(idx);
+#if (RFM == 1) && (RFM_TUNING > 0)
+		if (idx == (uint8_t)((uint16_t)&config.RFM_freqAdjust - (uint16_t)&config))
+		{
+			RFM_freq_update();
+		}
+#endif
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  \brief command G, read config byte, 0xff returns EE_LAYOUT
+ ******************************************************************************/
+static uint8_t COM_config_read(uint8_t idx)
+{
+	if (idx == 0xff)
+	{
+		return EE_LAYOUT;
+	}
+	idx = COM_config_idx(idx);
+	return (idx < CONFIG_RAW_SIZE) ? config_raw[idx] : 0xff;
+}
+
+
+#if OTA_UPDATE && (RFM == 1)
+/*!
+ *******************************************************************************
+ *  \brief request radio firmware update from bootloader
+ *
+ *  \note descriptor is valid after last write, bootloader needs reboot
+ *  \returns true if request was accepted
+ ******************************************************************************/
+static bool COM_ota_request(uint8_t pages, uint8_t crc_h, uint8_t crc_l)
+{
+	if (((pages & ~OTA_DELTA) == 0) || ((pages & ~OTA_DELTA) > OTA_PAGES_MAX) || (config.RFM_devaddr == 0))
+	{
+		return false;
+	}
+	EEPROM_write((uint16_t)&ee_ota[1], pages);
+	EEPROM_write((uint16_t)&ee_ota[2], crc_h);
+	EEPROM_write((uint16_t)&ee_ota[3], crc_l);
+	EEPROM_write((uint16_t)&ee_ota[4], 0);
+	EEPROM_write((uint16_t)&ee_ota[0], (uint8_t)((uint16_t)&config.RFM_devaddr - (uint16_t)&config));
+	return true;
+}
+#endif
 
 /*!
  *******************************************************************************
@@ -483,7 +569,7 @@ static void print_idx(char t, uint8_t i)
  *  \note   D\n - print status line
  *  \note   Taa\n - print watched variable aa (return 2 or 4 hex numbers) see to \ref watch.c
  *  \note   Gaa\n - get configuration byte with hex address aa see to \ref eeprom.h 0xff address returns EEPROM layout version
- *  \note   Saadd\n - set configuration byte aa to value dd (hex)
+ *  \note   Saadd\n - set configuration byte aa to value dd (hex), aa=fe is RFM_freqAdjust (applied immediately)
  *  \note   Rab\n - get timer for day a slot b, return cddd=(timermode c time ddd) (hex)
  *  \note   Wabcddd\n - set timer  for day a slot b timermode c time ddd (hex)
  *  \note   B1324\n - reboot, 1324 is password (fixed at this moment)
@@ -492,6 +578,11 @@ static void print_idx(char t, uint8_t i)
  *  \note   Axx\n - set wanted temperature [unit 0.5C]
  *  \note   Mxx\n - set mode and close window (00=manu 01=auto fd=nochange/close window only)
  *      \note	Lxx\n - Lock keys, and return lock status (00=unlock, 01=lock, 02=status only)
+ *  \note   Pxx\n - print motor profile xx (00=last move), 16 bytes see to \ref motor_profile_t
+ *  \note   Kaadd\n - set valve characteristic byte aa to dd (ff=read only) see to \ref ee_valve_curve
+ *  \note   Uxx\n - PID auto-tuning (00=abort, 01=start, 02=status only), return state see to \ref CTL_tune_state
+ *  \note   Fppcccc\n - radio firmware update of pp pages with CRC cccc (pp|80 delta), reboot to bootloader see to common/ota.h
+ *  \note   Nxx\n - print radio link counter xx, see WL_STAT_* in common/wireless.h
  *
  ******************************************************************************/
 void COM_commad_parse(void)
@@ -527,6 +618,65 @@ void COM_commad_parse(void)
 			print_hexXXXX(watch(com_hex[0]));
 		}
 		break;
+#if VALVE_CURVE
+		case 'K':
+			if (COM_hex_parse(2 * 2) != '\0')
+			{
+				break;
+			}
+			if (com_hex[1] != 0xff)
+			{
+				CTL_valve_curve_write(com_hex[0], com_hex[1]);
+			}
+			print_idx(c, com_hex[0]);
+			print_hexXX(CTL_valve_curve_read(com_hex[0]));
+			break;
+#endif
+#if DEBUG_MOTOR_PROFILE
+		case 'P':
+		{
+			uint8_t i;
+			const uint8_t *p;
+			if (COM_hex_parse(1 * 2) != '\0')
+			{
+				break;
+			}
+			print_idx(c, com_hex[0]);
+			p = (const uint8_t *)MOTOR_profile_get(com_hex[0]);
+			for (i = 0; i < sizeof(motor_profile_t); i++)
+			{
+				print_hexXX(p[i]);
+			}
+		}
+		break;
+#endif
+#if DEBUG_WATCH_TRACE
+		case 'Z':
+			if (COM_hex_parse(3 * 2) != '\0')
+			{
+				break;
+			}
+			watch_trace_config(((uint16_t)com_hex[1] << 8) | com_hex[2], com_hex[0]);
+			print_idx(c, watch_trace_interval);
+			print_hexXXXX(watch_trace_mask);
+			break;
+		case 'J':
+		{
+			uint16_t buf[WATCH_TRACE_FETCH];
+			uint8_t i, n;
+			if (COM_hex_parse(1 * 2) != '\0')
+			{
+				break;
+			}
+			n = watch_trace_fetch(com_hex, buf);
+			print_idx(c, com_hex[0]);
+			for (i = 0; i < n; i++)
+			{
+				print_hexXXXX(buf[i]);
+			}
+		}
+		break;
+#endif
 		case 'G':
 		case 'S':
 			if (c == 'G')
@@ -542,21 +692,10 @@ void COM_commad_parse(void)
 				{
 					break;
 				}
-				if (com_hex[0] < CONFIG_RAW_SIZE)
-				{
-					config_raw[com_hex[0]] = (uint8_t)(com_hex[1]);
-					eeprom_config_save(com_hex[0]);
-				}
+				COM_config_write(com_hex[0], com_hex[1]);
 			}
 			print_idx(c, com_hex[0]);
-			if (com_hex[0] == 0xff)
-			{
-				print_hexXX(EE_LAYOUT);
-			}
-			else
-			{
-				print_hexXX(config_raw[com_hex[0]]);
-			}
+			print_hexXX(COM_config_read(com_hex[0]));
 			break;
 		case 'R':
 		case 'W':
@@ -612,6 +751,9 @@ void COM_commad_parse(void)
 			}
 			if ((com_hex[0] == 0x13) && (com_hex[1] == 0x24))
 			{
+#if CONTROLLER_CHECKPOINT
+				CTL_checkpoint_save();
+#endif
 				cli();
 				wdt_enable(WDTO_15MS);  //wd on,15ms
 				while (1)
@@ -621,6 +763,26 @@ void COM_commad_parse(void)
 			}
 		}
 		break;
+#if OTA_UPDATE && (RFM == 1)
+		case 'F':
+			if (COM_hex_parse(3 * 2) != '\0')
+			{
+				break;
+			}
+			if (COM_ota_request(com_hex[0], com_hex[1], com_hex[2]))
+			{
+#if CONTROLLER_CHECKPOINT
+				CTL_checkpoint_save();
+#endif
+				cli();
+				wdt_enable(WDTO_15MS);  //wd on,15ms
+				while (1)
+				{
+					;               //loop till reset
+				}
+			}
+			break;
+#endif
 		case 'M':
 			if (COM_hex_parse(1 * 2) != '\0')
 			{
@@ -656,6 +818,29 @@ void COM_commad_parse(void)
 			}
 			print_hexXX(menu_locked);
 			break;
+#if PID_AUTOTUNE
+		case 'U':
+			if (COM_hex_parse(1 * 2) != '\0')
+			{
+				break;
+			}
+			if (com_hex[0] <= 1)
+			{
+				CTL_tune(com_hex[0]);
+			}
+			print_hexXX(CTL_tune_state);
+			break;
+#endif
+#if (RFM == 1)
+		case 'N':
+			if (COM_hex_parse(1 * 2) != '\0')
+			{
+				break;
+			}
+			print_idx(c, com_hex[0]);
+			print_hexXXXX((com_hex[0] < WL_STAT_N) ? wl_stat[com_hex[0]] : 0);
+			break;
+#endif
 #endif
 		//case '\n':
 		//case '\0':
@@ -693,7 +878,8 @@ void COM_wireless_command_parse(uint8_t *rfm_framebuf, uint8_t rfm_framepos)
 	while (rfm_framepos > pos)
 	{
 		uint8_t c = rfm_framebuf[pos++];
-		wireless_putchar(c | 0x80);
+		uint8_t reply = wireless_buf_ptr;
+		wireless_putchar(c | PROTO_REPLY);
 		switch (c)
 		{
 		case 'V':
@@ -705,32 +891,58 @@ void COM_wireless_command_parse(uint8_t *rfm_framebuf, uint8_t rfm_framepos)
 		case 'T':
 			wireless_putchar(rfm_framebuf[pos]);
 			COM_wireless_word(watch(rfm_framebuf[pos]));
-			pos++;
 			break;
-		case 'G':
-		case 'S':
-			if (c == 'S')
+#if VALVE_CURVE
+		case 'K':
+			if (rfm_framebuf[pos + 1] != 0xff)
 			{
-				if (rfm_framebuf[pos] < CONFIG_RAW_SIZE)
-				{
-					config_raw[rfm_framebuf[pos]] = (uint8_t)(rfm_framebuf[pos + 1]);
-					eeprom_config_save(rfm_framebuf[pos]);
-				}
+				CTL_valve_curve_write(rfm_framebuf[pos], rfm_framebuf[pos + 1]);
 			}
 			wireless_putchar(rfm_framebuf[pos]);
-			if (rfm_framebuf[pos] == 0xff)
+			wireless_putchar(CTL_valve_curve_read(rfm_framebuf[pos]));
+			break;
+#endif
+#if DEBUG_MOTOR_PROFILE
+		case 'P':
+		{
+			uint8_t i;
+			const uint8_t *p = (const uint8_t *)MOTOR_profile_get(rfm_framebuf[pos]);
+			wireless_putchar(rfm_framebuf[pos]);
+			for (i = 0; i < sizeof(motor_profile_t); i++)
 			{
-				wireless_putchar(EE_LAYOUT);
+				wireless_putchar(p[i]);
 			}
-			else
+		}
+		break;
+#endif
+#if DEBUG_WATCH_TRACE
+		case 'Z':
+			watch_trace_config(((uint16_t)rfm_framebuf[pos + 1] << 8) | rfm_framebuf[pos + 2], rfm_framebuf[pos]);
+			wireless_putchar(watch_trace_interval);
+			COM_wireless_word(watch_trace_mask);
+			break;
+		case 'J':
+		{
+			uint16_t buf[WATCH_TRACE_FETCH];
+			uint8_t i, n;
+			n = watch_trace_fetch(&rfm_framebuf[pos], buf);
+			wireless_putchar(rfm_framebuf[pos]);
+			wireless_putchar(n * 2);
+			for (i = 0; i < n; i++)
 			{
-				wireless_putchar(config_raw[rfm_framebuf[pos]]);
+				COM_wireless_word(buf[i]);
 			}
+		}
+		break;
+#endif
+		case 'G':
+		case 'S':
 			if (c == 'S')
 			{
-				pos++;
+				COM_config_write(rfm_framebuf[pos], rfm_framebuf[pos + 1]);
 			}
-			pos++;
+			wireless_putchar(rfm_framebuf[pos]);
+			wireless_putchar(COM_config_read(rfm_framebuf[pos]));
 			break;
 		case 'R':
 		case 'W':
@@ -746,11 +958,6 @@ void COM_wireless_command_parse(uint8_t *rfm_framebuf, uint8_t rfm_framepos)
 			wireless_putchar(rfm_framebuf[pos]);
 			COM_wireless_word(eeprom_timers_read_raw(
 						  timers_get_raw_index((rfm_framebuf[pos] >> 4), (rfm_framebuf[pos] & 0xf))));
-			if (c == 'W')
-			{
-				pos += 2;
-			}
-			pos++;
 			break;
 		case 'B':
 			if ((rfm_framebuf[pos] == 0x13) && (rfm_framebuf[pos + 1] == 0x24))
@@ -759,22 +966,30 @@ void COM_wireless_command_parse(uint8_t *rfm_framebuf, uint8_t rfm_framepos)
 			}
 			wireless_putchar(rfm_framebuf[pos]);
 			wireless_putchar(rfm_framebuf[pos + 1]);
-			pos += 2;
 			break;
+#if OTA_UPDATE
+		case 'F':
+			if (COM_ota_request(rfm_framebuf[pos], rfm_framebuf[pos + 1], rfm_framebuf[pos + 2]))
+			{
+				reboot = true;
+				wireless_putchar(rfm_framebuf[pos]);
+			}
+			else
+			{
+				wireless_putchar(0);
+			}
+			break;
+#endif
 		case 'M':
-			CTL_change_mode(rfm_framebuf[pos++]);
+			CTL_change_mode(rfm_framebuf[pos]);
 			COM_print_debug(2);
 			break;
 		case 'A':
-			if (rfm_framebuf[pos] < TEMP_MIN - 1)
-			{
-				break;
-			}
-			if (rfm_framebuf[pos] > TEMP_MAX + 1)
+			// out of range is ignored, status is sent anyway (reply length from table)
+			if ((rfm_framebuf[pos] >= TEMP_MIN - 1) && (rfm_framebuf[pos] <= TEMP_MAX + 1))
 			{
-				break;
+				CTL_set_temp(rfm_framebuf[pos]);
 			}
-			CTL_set_temp(rfm_framebuf[pos++]);
 			COM_print_debug(2);
 			break;
 		case 'L':
@@ -783,11 +998,28 @@ void COM_wireless_command_parse(uint8_t *rfm_framebuf, uint8_t rfm_framepos)
 				menu_locked = rfm_framebuf[pos];
 			}
 			wireless_putchar(menu_locked);
-			pos++;
+			break;
+#if PID_AUTOTUNE
+		case 'U':
+			if (rfm_framebuf[pos] <= 1)
+			{
+				CTL_tune(rfm_framebuf[pos]);
+			}
+			wireless_putchar(CTL_tune_state);
+			break;
+#endif
+		case 'N':
+			wireless_putchar(rfm_framebuf[pos]);
+			COM_wireless_word((rfm_framebuf[pos] < WL_STAT_N) ? wl_stat[rfm_framebuf[pos]] : 0);
 			break;
 		default:
+			// unknown or not compiled in, take back command byte, no reply at all
+			// keeps next replies aligned for decoder using reply length from table
+			wireless_buf_ptr = reply;
 			break;
 		}
+		// parameters are skipped by table, also for commands not compiled in
+		pos += proto_request_len(c);
 	}
 }
 #endif
@@ -33,7 +33,9 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <avr/pgmspace.h>
+#include <util/crc16.h>
 
 #include "config.h"
 #include "main.h"
@@ -44,6 +46,8 @@
 #include "eeprom.h"
 #include "controller.h"
 #include "keyboard.h"
+#include "motor.h"
+#include "watch.h"
 
 // global Vars for default values: temperatures and speed
 uint8_t CTL_temp_wanted = 0;                    // actual desired temperature
@@ -64,6 +68,7 @@ uint8_t PID_boost_timeout = 0;                          //boost timout in minute
 static uint16_t PID_update_timeout = AVERAGE_LEN + 1;   // timer to next PID controler action/first is 16 sec after statup
 int8_t PID_force_update = AVERAGE_LEN + 1;              // signed value, val<0 means disable force updates \todo rename
 uint8_t valveHistory[VALVE_HISTORY_LEN];
+bool CTL_valve_force = false;                           // setpoint change, valve moves without planner delay
 
 static uint8_t pid_Controller(int16_t setPoint, int16_t processValue, uint8_t old_result, bool updateNow);
 
@@ -172,6 +177,513 @@ static void CTL_window_detection(void)
 }
 #endif
 
+#if VALVE_CURVE
+/*!
+ *******************************************************************************
+ *  write one byte of valve characteristic \ref ee_valve_curve
+ *
+ *  \param idx index, 0 is state
+ *  \param value new value
+ ******************************************************************************/
+void CTL_valve_curve_write(uint8_t idx, uint8_t value)
+{
+	uint16_t a = (uint16_t)&ee_valve_curve[idx];
+
+	if ((idx < VALVE_CURVE_SIZE) && (EEPROM_read(a) != value))
+	{
+		EEPROM_write(a, value);
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  read one byte of valve characteristic \ref ee_valve_curve
+ *
+ *  \param idx index, 0 is state
+ *  \returns value, 0xff for index out of table
+ ******************************************************************************/
+uint8_t CTL_valve_curve_read(uint8_t idx)
+{
+	return (idx < VALVE_CURVE_SIZE) ? EEPROM_read((uint16_t)&ee_valve_curve[idx]) : 0xff;
+}
+
+#define VALVE_CURVE_DEAD 4              // PID intervals without reaction
+#define VALVE_CURVE_ERR 50              // unit 0.01C
+#define VALVE_CURVE_RISE 5              // unit 0.01C per PID interval
+#define VALVE_CURVE_MAX_OPEN 60         // limit for learned opening point [%]
+#define VALVE_CURVE_STEP 4              // maximum move of opening point up in one step [%]
+static int16_t vc_last_temp;
+static uint8_t vc_last_stroke = 0xff;
+static uint8_t vc_dead = 0;
+static uint8_t vc_closed = 0;           // stroke without reaction, waits for confirmation
+
+/*!
+ *******************************************************************************
+ *  learn opening point of valve from temperature response
+ *
+ *  \note called on regular PID update, stroke must be same as on last update
+ *  \note - under setpoint and temperature does not rise for VALVE_CURVE_DEAD
+ *          intervals: valve may be still closed on this stroke, remember it
+ *  \note - temperature rises later on higher stroke: heating works and
+ *          remembered stroke was closed, move opening point up to it, at most
+ *          VALVE_CURVE_STEP at once (cold room with boiler off teaches nothing)
+ *  \note - over setpoint and temperature rises on lowest flow (10%):
+ *          opening point is too high, move it down
+ *  \note flow 1-100% is mapped linearly to stroke from opening point to 100%,
+ *        uploaded table (\ref VALVE_CURVE_UPLOADED) is never changed
+ ******************************************************************************/
+static void CTL_valve_curve_learn(int16_t setPoint, int16_t processValue)
+{
+	uint8_t s = MOTOR_GetPosPercent();
+	int16_t dt = processValue - vc_last_temp;
+	bool stable = (s == vc_last_stroke);
+	uint8_t st = EEPROM_read((uint16_t)&ee_valve_curve[0]);
+	uint8_t o = 0;
+	uint8_t o_new;
+
+	vc_last_temp = processValue;
+	vc_last_stroke = s;
+	if (st == VALVE_CURVE_LEARNED)
+	{
+		o = EEPROM_read((uint16_t)&ee_valve_curve[10]);
+	}
+	if ((st == VALVE_CURVE_UPLOADED) || (s == 0) || (s > 100) || mode_window() || !stable)
+	{
+		vc_dead = 0;
+		return;
+	}
+	o_new = o;
+	if ((processValue < setPoint - VALVE_CURVE_ERR) && (dt <= 0))
+	{
+		if ((++vc_dead >= VALVE_CURVE_DEAD) && (s > o))
+		{
+			vc_closed = (s > VALVE_CURVE_MAX_OPEN) ? VALVE_CURVE_MAX_OPEN : s;
+			vc_dead = 0;
+		}
+	}
+	else
+	{
+		vc_dead = 0;
+		if (dt >= VALVE_CURVE_RISE)
+		{
+			if ((vc_closed > o) && (s > vc_closed))
+			{
+				o_new = (vc_closed > o + VALVE_CURVE_STEP) ? o + VALVE_CURVE_STEP : vc_closed;
+			}
+			// confirmed, or rise on remembered stroke itself (slow reaction)
+			vc_closed = 0;
+			if ((processValue > setPoint + VALVE_CURVE_ERR)
+			    && (o >= 2) && (s <= o + (100 - o) / 10))
+			{
+				o_new = o - 2;
+			}
+		}
+	}
+	if ((o_new >= o + 2) || (o_new + 2 <= o))
+	{
+		uint8_t k;
+		for (k = 1; k <= 9; k++)
+		{
+			CTL_valve_curve_write(k, o_new + (uint8_t)(((uint16_t)(100 - o_new) * k) / 10));
+		}
+		CTL_valve_curve_write(10, o_new);
+		CTL_valve_curve_write(0, VALVE_CURVE_LEARNED);
+	}
+}
+#endif
+
+#if PID_AUTOTUNE
+#define TUNE_HYST 10            // relay hysteresis around setpoint, unit 0.01C
+#define TUNE_CYCLES 3           // measured periods, first period is not used
+#define TUNE_TIMEOUT 28800      // maximum length of one period [s]
+#define TUNE_MIN_AMP 5          // minimum amplitude of oscillation, unit 0.01C
+uint8_t CTL_tune_state = CTL_TUNE_IDLE;
+static int16_t tune_setpoint;
+static bool tune_high;
+static uint16_t tune_sec;       // seconds from begin of current period
+static uint16_t tune_high_sec;  // length of high part of current period
+static int16_t tune_tmin;
+static int16_t tune_tmax;
+static uint32_t tune_sum_period;
+static uint32_t tune_sum_high;
+static uint16_t tune_sum_amp;
+
+/*!
+ *******************************************************************************
+ *  start or abort relay auto-tuning
+ *
+ *  \param start true = start new experiment, false = abort running one
+ ******************************************************************************/
+void CTL_tune(bool start)
+{
+	if (start)
+	{
+		tune_setpoint = calc_temp(CTL_temp_wanted);
+		tune_high = true;
+		tune_sec = 0;
+		tune_tmin = tune_tmax = temp_average;
+		tune_sum_period = 0;
+		tune_sum_high = 0;
+		tune_sum_amp = 0;
+		valveHistory[0] = config.valve_max;
+		CTL_tune_state = CTL_TUNE_RUN;
+	}
+	else if (CTL_tune_running())
+	{
+		CTL_tune_state = CTL_TUNE_IDLE;
+		PID_force_update = 0;
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  save one tuned value, limited to min/max from \ref ee_config
+ ******************************************************************************/
+static uint8_t CTL_tune_save(uint8_t idx, uint32_t value)
+{
+	uint8_t min = config_min(idx);
+	uint8_t max = config_max(idx);
+
+	if (value < min)
+	{
+		value = min;
+	}
+	else if (value > max)
+	{
+		value = max;
+	}
+	config_raw[idx] = (uint8_t)value;
+	eeprom_config_save(idx);
+	return (uint8_t)value;
+}
+
+/*!
+ *******************************************************************************
+ *  one second step of relay auto-tuning
+ *
+ *  \note valve is switched between valve_max and valve_min when temp_average
+ *        crosses setpoint +-TUNE_HYST. From period Tu and amplitude a of
+ *        resulting oscillation is ultimate gain Ku = 4*d/(pi*a), d is half
+ *        of relay step.
+ *  \note PI parameters are calculated by Tyreus-Luyben rule (Kp = Ku/3.2,
+ *        Ti = 2.2*Tu), it gives less overshoot and less motor travel than
+ *        Ziegler-Nichols on slow radiators. Scaling of pid_Controller:
+ *        Kp[%/0.01C] = P_Factor/256, Ti[s] = P_Factor*160*PID_interval/I_Factor
+ *  \note PID_interval is set to Tu/20, valve_center to average relay output,
+ *        P3_Factor is not changed
+ ******************************************************************************/
+static void CTL_tune_step(void)
+{
+	int16_t t = temp_average;
+
+	if ((CTL_temp_wanted < TEMP_MIN) || (CTL_temp_wanted > TEMP_MAX) || mode_window()
+	    || (calc_temp(CTL_temp_wanted) != tune_setpoint) || (++tune_sec > TUNE_TIMEOUT))
+	{
+		CTL_tune_state = CTL_TUNE_FAIL;
+		PID_force_update = 0;
+		return;
+	}
+	if (t > tune_tmax)
+	{
+		tune_tmax = t;
+	}
+	if (t < tune_tmin)
+	{
+		tune_tmin = t;
+	}
+	if (tune_high)
+	{
+		if (t > tune_setpoint + TUNE_HYST)
+		{
+			tune_high = false;
+			tune_high_sec = tune_sec;
+			valveHistory[0] = config.valve_min;
+			CTL_tune_state++;
+		}
+		return;
+	}
+	if (t >= tune_setpoint - TUNE_HYST)
+	{
+		return;
+	}
+	// end of period
+	if (CTL_tune_state >= CTL_TUNE_RUN + 3)
+	{
+		tune_sum_period += tune_sec;
+		tune_sum_high += tune_high_sec;
+		tune_sum_amp += tune_tmax - tune_tmin;
+	}
+	tune_high = true;
+	tune_sec = 0;
+	tune_tmin = tune_tmax = t;
+	valveHistory[0] = config.valve_max;
+	if (++CTL_tune_state < CTL_TUNE_RUN + 1 + 2 * TUNE_CYCLES + 1)
+	{
+		return;
+	}
+	{
+		// tune_sum_amp is TUNE_CYCLES * peak to peak = 2 * TUNE_CYCLES * a
+		uint16_t tu = tune_sum_period / TUNE_CYCLES;
+		uint8_t d = (config.valve_max - config.valve_min) / 2;
+		uint8_t p, pid_interval;
+		if ((tune_sum_amp < 2 * TUNE_CYCLES * TUNE_MIN_AMP) || (d == 0))
+		{
+			CTL_tune_state = CTL_TUNE_FAIL;
+			PID_force_update = 0;
+			return;
+		}
+		CTL_tune_save((uint16_t)(&config.valve_center) - (uint16_t)(&config),
+			      config.valve_min + ((config.valve_max - config.valve_min) * tune_sum_high) / tune_sum_period);
+		pid_interval = CTL_tune_save((uint16_t)(&config.PID_interval) - (uint16_t)(&config), tu / (20 * 5));
+		// P_Factor = 256*Ku/3.2 = 256*4*d/(3.2*pi*a) = 102*d/a
+		p = CTL_tune_save((uint16_t)(&config.P_Factor) - (uint16_t)(&config),
+				  ((uint32_t)d * 102 * 2 * TUNE_CYCLES) / tune_sum_amp);
+		// I_Factor = P_Factor*160*PID_interval/(2.2*Tu)
+		CTL_tune_save((uint16_t)(&config.I_Factor) - (uint16_t)(&config),
+			      ((uint32_t)p * pid_interval * 73) / tu);
+	}
+	sumError = 0;
+	CTL_tune_state = CTL_TUNE_DONE;
+	PID_force_update = 0;
+}
+#endif
+
+#if CONTROLLER_CHECKPOINT
+bool CTL_checkpoint_restored = false;   // restored sumError and credit survive first calibration
+static bool checkpoint_seed = false;    // first PID step continues from restored state
+static uint8_t checkpoint_slot = CHECKPOINT_N - 1;
+
+/*!
+ *******************************************************************************
+ *  read checkpoint slot, check CRC
+ *
+ *  \note CRC is initialized by EE_LAYOUT, record from other layout is invalid
+ *  \returns true if record is valid
+ ******************************************************************************/
+static bool CTL_checkpoint_read(uint8_t slot, uint8_t *buf)
+{
+	uint8_t crc = _crc_ibutton_update(0, EE_LAYOUT);
+	uint8_t i;
+
+	for (i = 0; i < CHECKPOINT_SIZE; i++)
+	{
+		buf[i] = EEPROM_read((uint16_t)&ee_checkpoint[slot][i]);
+		crc = _crc_ibutton_update(crc, buf[i]);
+	}
+	return crc == 0; // CRC over data and CRC byte is 0
+}
+
+/*!
+ *******************************************************************************
+ *  save controller state to EEPROM
+ *
+ *  \note called every hour and before reboot by command B
+ *  \note records are written to ring of CHECKPOINT_N slots (wear spreading),
+ *        unchanged state is not written
+ ******************************************************************************/
+void CTL_checkpoint_save(void)
+{
+	uint8_t buf[CHECKPOINT_SIZE];
+	uint8_t old[CHECKPOINT_SIZE];
+	uint8_t crc = _crc_ibutton_update(0, EE_LAYOUT);
+	uint8_t i;
+	bool valid = CTL_checkpoint_read(checkpoint_slot, old);
+
+	buf[0] = old[0] + 1;
+	*(int32_t *)(buf + 1) = sumError;
+	buf[5] = CTL_interatorCredit;
+	buf[6] = valve_wanted;
+	if (valid && (memcmp(buf + 1, old + 1, CHECKPOINT_SIZE - 2) == 0))
+	{
+		return;
+	}
+	for (i = 0; i < CHECKPOINT_SIZE - 1; i++)
+	{
+		crc = _crc_ibutton_update(crc, buf[i]);
+	}
+	buf[CHECKPOINT_SIZE - 1] = crc;
+	checkpoint_slot = (checkpoint_slot + 1) % CHECKPOINT_N;
+	for (i = 0; i < CHECKPOINT_SIZE; i++)
+	{
+		EEPROM_write((uint16_t)&ee_checkpoint[checkpoint_slot][i], buf[i]);
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  restore controller state from newest valid checkpoint
+ *
+ *  \note call it from init after eeprom_config_init
+ *  \note newest record is valid record without valid successor (sequence+1)
+ *  \param restore_default true = invalidate all checkpoints, do not restore
+ ******************************************************************************/
+void CTL_checkpoint_restore(bool restore_default)
+{
+	uint8_t buf[CHECKPOINT_SIZE];
+	uint8_t next[CHECKPOINT_SIZE];
+	uint8_t i;
+
+	for (i = 0; i < CHECKPOINT_N; i++)
+	{
+		if (restore_default)
+		{
+			EEPROM_write((uint16_t)&ee_checkpoint[i][CHECKPOINT_SIZE - 1],
+				     ~EEPROM_read((uint16_t)&ee_checkpoint[i][CHECKPOINT_SIZE - 1]));
+			continue;
+		}
+		if (!CTL_checkpoint_read(i, buf))
+		{
+			continue;
+		}
+		if (CTL_checkpoint_read((i + 1) % CHECKPOINT_N, next) && (next[0] == (uint8_t)(buf[0] + 1)))
+		{
+			continue;
+		}
+		checkpoint_slot = i;
+		sumError = *(int32_t *)(buf + 1);
+		CTL_interatorCredit = buf[5];
+		valve_wanted = buf[6];
+		CTL_checkpoint_restored = true;
+		checkpoint_seed = true;
+		return;
+	}
+}
+#endif
+
+#if OPTIMAL_START
+#define PREHEAT_RATE_DEFAULT 20         // unit 0.1C per hour, used until rate is learned
+#define PREHEAT_LEARN_MIN_DIFF 100      // minimal error on start of learned heat-up, unit 0.01C
+#define PREHEAT_LEARN_END 20            // heat-up is finished on setpoint-PREHEAT_LEARN_END, unit 0.01C
+#define PREHEAT_LEARN_TIMEOUT (6 * 60)  // [minutes]
+static uint8_t pl_wanted;
+static int16_t pl_start;                // start temperature of learned heat-up, 0 = not active
+static uint16_t pl_minutes;
+
+/*!
+ *******************************************************************************
+ *  \returns address of \ref ee_preheat_rate for start temperature
+ ******************************************************************************/
+static uint16_t CTL_preheat_rate_addr(int16_t start)
+{
+	uint8_t i = 0;
+
+	if (start >= 1600)
+	{
+		i = (start >= 2000) ? 3 : ((start >= 1800) ? 2 : 1);
+	}
+	return (uint16_t)&ee_preheat_rate[i];
+}
+
+/*!
+ *******************************************************************************
+ *  learn heat-up rate from setpoint increase
+ *
+ *  \note called every minute; measure starts when wanted temperature rises
+ *        at least 1C over actual temperature in auto mode and ends when
+ *        temperature is near setpoint. Abort on open window, closed valve
+ *        or timeout.
+ *  \note stored rate is filtered, new = (3*old + measured)/4
+ ******************************************************************************/
+static void CTL_preheat_learn(void)
+{
+	int16_t target = calc_temp(CTL_temp_wanted);
+
+	if (CTL_temp_wanted != pl_wanted)
+	{
+		pl_start = 0;
+		pl_minutes = 0;
+		if (CTL_mode_auto && (CTL_temp_wanted > pl_wanted) && (CTL_temp_wanted <= TEMP_MAX)
+		    && (temp_average < target - PREHEAT_LEARN_MIN_DIFF))
+		{
+			pl_start = temp_average;
+		}
+		pl_wanted = CTL_temp_wanted;
+		return;
+	}
+	if (pl_start == 0)
+	{
+		return;
+	}
+	if (mode_window() || (valve_wanted <= config.valve_min) || (++pl_minutes > PREHEAT_LEARN_TIMEOUT))
+	{
+		pl_start = 0;
+		return;
+	}
+	if (temp_average >= target - PREHEAT_LEARN_END)
+	{
+		uint16_t a = CTL_preheat_rate_addr(pl_start);
+		uint8_t old = EEPROM_read(a);
+		uint16_t rate = ((uint16_t)(temp_average - pl_start) * 6) / pl_minutes;
+		if (rate == 0)
+		{
+			rate = 1;
+		}
+		else if (rate > 254)
+		{
+			rate = 254;
+		}
+		if (old != 0xff)
+		{
+			rate = (3 * (uint16_t)old + rate + 2) / 4;
+		}
+		if (old != rate)
+		{
+			EEPROM_write(a, rate);
+		}
+		pl_start = 0;
+	}
+}
+
+/*!
+ *******************************************************************************
+ *  optimal start, switch to next timer temperature before timer
+ *
+ *  \note called every minute, next timer is searched by \ref RTC_NextTimer
+ *  \note preheat time = (wanted - actual temperature) / learned rate,
+ *        limited by config.preheat_max
+ *  \note CTL_temp_auto_type is set to next timer type, so CTL_test_auto()
+ *        is true and timer itself does not change anything
+ ******************************************************************************/
+static void CTL_preheat(void)
+{
+	uint8_t type;
+	uint16_t m;
+
+	if (!CTL_mode_auto || (config.preheat_max == 0) || mode_window()
+	    || (CTL_temp_auto_type == TEMP_TYPE_INVALID))
+	{
+		return;
+	}
+	m = RTC_NextTimer(&type);
+	if (m > config.preheat_max)
+	{
+		return;
+	}
+	{
+		uint8_t t = temperature_table[type];
+		int16_t diff = calc_temp(t) - temp_average;
+		uint8_t rate = EEPROM_read(CTL_preheat_rate_addr(temp_average));
+		if ((t <= CTL_temp_wanted) || (t > TEMP_MAX) || (diff <= 0))
+		{
+			return;
+		}
+		if (rate == 0xff)
+		{
+			rate = PREHEAT_RATE_DEFAULT;
+		}
+		if (((uint16_t)diff * 6) / rate >= m)
+		{
+			CTL_temp_auto_type = type;
+			CTL_temp_wanted = t;
+			if (PID_force_update < 0)
+			{
+				PID_force_update = 0;
+			}
+		}
+	}
+}
+#endif
+
 /*!
  *******************************************************************************
  *  Controller update
@@ -203,6 +715,19 @@ void CTL_update(bool minute_ch)
 			}
 		}
 	}
+#if OPTIMAL_START
+	if (minute_ch)
+	{
+		CTL_preheat_learn();
+		CTL_preheat();
+	}
+#endif
+#if CONTROLLER_CHECKPOINT
+	if (minute_ch && (RTC_GetMinute() == 0))
+	{
+		CTL_checkpoint_save();
+	}
+#endif
 #if BOOST_CONTROLER_AFTER_CHANGE
 	if (minute_ch && (PID_boost_timeout > 0))
 	{
@@ -219,6 +744,20 @@ void CTL_update(bool minute_ch)
 	{
 		PID_update_timeout--;
 	}
+	uint8_t report = 0; // bit 0: status line, bit 1: trace sample
+#if PID_AUTOTUNE
+	if (CTL_tune_running())
+	{
+		CTL_tune_step();
+		// keep status line and trace at PID interval, tuning is worth watching
+		if (PID_update_timeout == 0)
+		{
+			PID_update_timeout = (config.PID_interval * 5);
+			report = 3;
+		}
+	}
+	else
+#endif
 	if (PID_force_update > 0)
 	{
 		PID_force_update--;
@@ -234,6 +773,14 @@ void CTL_update(bool minute_ch)
 		{
 			temp = CTL_temp_wanted;
 		}
+#if CONTROLLER_CHECKPOINT
+		if (checkpoint_seed)
+		{
+			// first step after reboot is not a setpoint change, keep restored credit and valve
+			checkpoint_seed = false;
+			CTL_temp_wanted_last = temp;
+		}
+#endif
 		bool updateNow = (temp != CTL_temp_wanted_last);
 		if (updateNow || (PID_update_timeout == 0))
 		{
@@ -246,8 +793,18 @@ void CTL_update(bool minute_ch)
 			else
 			{
 				new_valve = pid_Controller(calc_temp(temp), temp_average, valveHistory[0], updateNow);
+#if VALVE_CURVE
+				if (!updateNow)
+				{
+					CTL_valve_curve_learn(calc_temp(temp), temp_average);
+				}
+#endif
 			}
 			CTL_temp_wanted_last = temp;
+			if (updateNow)
+			{
+				CTL_valve_force = true;
+			}
 			{
 				int8_t i;
 #if BLOCK_INTEGRATOR_AFTER_VALVE_CHANGE
@@ -273,10 +830,21 @@ void CTL_update(bool minute_ch)
 				}
 				valveHistory[0] = new_valve;
 			}
+			report = 2;
 		}
-		COM_print_debug(0);
+		report |= 1;
 		PID_force_update = -1; // invalid value = not used
 	}
+#if DEBUG_WATCH_TRACE
+	if (report & 2)
+	{
+		watch_trace_sample(true);
+	}
+#endif
+	if (report & 1)
+	{
+		COM_print_debug(0);
+	}
 	// batt error detection
 	if (bat_average)
 	{
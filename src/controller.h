@@ -46,6 +46,7 @@ extern uint8_t CTL_mode_window;
 #define VALVE_HISTORY_LEN 1
 extern uint8_t valveHistory[VALVE_HISTORY_LEN];
 #define valve_wanted (valveHistory[0])
+extern bool CTL_valve_force;    // next MOTOR_Goto skips planner, cleared by main
 
 #define CTL_update_temp_auto() (CTL_temp_auto_type = TEMP_TYPE_INVALID)
 #define CTL_test_auto() (CTL_mode_auto && (CTL_temp_auto_type != TEMP_TYPE_INVALID) && (temperature_table[CTL_temp_auto_type] == CTL_temp_wanted))
@@ -62,6 +63,27 @@ void CTL_temp_change_inc(int8_t ch);
 #define CTL_CLOSE_WINDOW_FORCE -3
 void CTL_change_mode(int8_t dif);
 
+#if VALVE_CURVE
+void CTL_valve_curve_write(uint8_t idx, uint8_t value);
+uint8_t CTL_valve_curve_read(uint8_t idx);
+#endif
+
+#if CONTROLLER_CHECKPOINT
+extern bool CTL_checkpoint_restored;
+void CTL_checkpoint_save(void);
+void CTL_checkpoint_restore(bool restore_default);
+#endif
+
+#if PID_AUTOTUNE
+#define CTL_TUNE_IDLE 0
+#define CTL_TUNE_RUN 1          // 1 .. CTL_TUNE_DONE-1 is running, value-1 is count of relay switches
+#define CTL_TUNE_DONE 0x40      // new parameters are saved in config
+#define CTL_TUNE_FAIL 0x80      // aborted, config is unchanged
+extern uint8_t CTL_tune_state;
+#define CTL_tune_running() ((CTL_tune_state >= CTL_TUNE_RUN) && (CTL_tune_state < CTL_TUNE_DONE))
+void CTL_tune(bool start);
+#endif
+
 #define DEFINE_INTEGRATOR_BLOCK 6
 #define I_ERR_TOLLERANCE_AROUND_0 15    // unit 0,01°C. Set it quite restrictive !
 #define I_ERR_WEIGHT 25                 //impact of error on I part
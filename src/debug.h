@@ -50,6 +50,8 @@
 #define DEBUG_PRINT_ADDITIONAL_TIMESTAMPS DEBUG_MODE
 #define DEBUG_IGNORE_MONT_CONTACT 0
 #define DEBUG_MOTOR_COUNTER  1
+#define DEBUG_MOTOR_PROFILE  1  // ring of last motor moves, command P
+#define DEBUG_WATCH_TRACE    1  // ring of watch() samples, commands Z and J
 
 #define DEBUG_BATT_ADC 0
 
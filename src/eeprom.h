@@ -43,6 +43,7 @@
 #include "rfm_config.h"
 #include "common/rfm.h"
 #endif
+#include "common/ota.h"
 
 
 #define EEPROM __attribute__((section(".eeprom")))
@@ -122,6 +123,20 @@ typedef struct                                                  // each variable
 #endif
 	/* unused */
 #endif
+	/*    */ uint8_t motor_move_interval;                   //!< minimal time between two valve moves [minutes]
+	/*    */ uint8_t motor_move_min;                        //!< smaller valve corrections are merged [%]
+	/*    */ uint8_t motor_travel_budget;                   //!< maximal valve travel per hour [%], 0 = unlimited
+	/*    */ uint8_t preheat_max;                           //!< maximal optimal start before timer [minutes], 0 = disabled
+	/*    */ uint8_t lcd_idle_timeout;                      //!< LCD power save after minutes without keys, 0 = disabled
+	/*    */ uint8_t lcd_idle_mode;                         //!< LCD power save: 0 = low frame rate, 1 = blank with heartbeat, 2 = LCD off
+	/*    */ uint8_t energy_cpu;                            //!< current of awake CPU [10uA], order of energy_* items is ENERGY_* in energy.h
+	/*    */ uint8_t energy_motor;                          //!< current of running motor [mA]
+	/*    */ uint8_t energy_rfm_rx;                         //!< current of RFM receiver [mA]
+	/*    */ uint8_t energy_rfm_tx;                         //!< current of RFM transmitter [mA]
+	/*    */ uint8_t energy_adc;                            //!< current of ADC and temperature sensor [10uA]
+	/*    */ uint8_t energy_lcd;                            //!< current of LCD [uA]
+	/*    */ uint8_t energy_base;                           //!< sleep current of whole device [uA]
+	/*    */ uint8_t bat_capacity;                          //!< battery capacity for life projection [100mAh]
 } config_t;
 
 extern config_t config;
@@ -131,6 +146,35 @@ extern config_t config;
 #define CONFIG_RAW_SIZE (sizeof(config_t))
 
 extern uint16_t EEPROM ee_timers[8][RTC_TIMERS_PER_DOW];
+
+/*! valve characteristic, flow (controller output) to stroke (motor position)
+ *  [0] state, [1..9] stroke [%] for flow 10%..90%, [10] learned opening point [%] */
+#define VALVE_CURVE_SIZE 11
+#define VALVE_CURVE_LINEAR 0xff         //!< state: not used (erased EEPROM)
+#define VALVE_CURVE_UPLOADED 0x01       //!< state: table uploaded by command K
+#define VALVE_CURVE_LEARNED 0x02        //!< state: table calculated from learned opening point
+extern uint8_t EEPROM ee_valve_curve[VALVE_CURVE_SIZE];
+
+/*! learned heat-up rate for optimal start [unit 0.1C per hour], 0xff = not learned
+ *  index is start temperature: <16C, <18C, <20C, >=20C */
+#define PREHEAT_RATE_SIZE 4
+extern uint8_t EEPROM ee_preheat_rate[PREHEAT_RATE_SIZE];
+
+/*! controller checkpoint ring, see to \ref CTL_checkpoint_save
+ *  record: [0] sequence, [1..4] sumError, [5] CTL_interatorCredit, [6] valve_wanted, [7] CRC */
+#define CHECKPOINT_N 5
+#define CHECKPOINT_SIZE 8
+extern uint8_t EEPROM ee_checkpoint[CHECKPOINT_N][CHECKPOINT_SIZE];
+
+/*! radio firmware update descriptor for bootloader, see to common/ota.h
+ *  address is fixed (OTA_EE_DESC), last bytes before ee_config */
+extern uint8_t EEPROM ee_ota[OTA_EE_DESC_SIZE];
+
+/*! journal for often changed config items, see to \ref eeprom_config_save
+ *  entry: [0] lap bit (0x80) | config index, [1] value; 0x7f index is erased entry */
+#define JOURNAL_N 16
+extern uint8_t EEPROM ee_journal[JOURNAL_N][2];
+#define config_journaled(idx) ((idx) == (uint8_t)((uint16_t)(&config.timer_mode) - (uint16_t)(&config)))
 extern uint8_t EEPROM ee_layout;
 
 // Boot Timeslots -> move to CONFIG.H
@@ -141,9 +185,9 @@ extern uint8_t EEPROM ee_layout;
 #define BOOT_OFF2     (21 * 60 + 0x1000)        //!<  21:00
 
 #if (HW_WINDOW_DETECTION)
-#define EE_LAYOUT (0x15)
+#define EE_LAYOUT (0x1d)
 #else
-#define EE_LAYOUT (0x14)
+#define EE_LAYOUT (0x1c)
 #endif
 #if (BOOST_CONTROLER_AFTER_CHANGE) || (TEMP_COMPENSATE_OPTION)
 #define EE_LAYOUT (0xff)
@@ -183,18 +227,31 @@ uint16_t EEPROM ee_timers[8][RTC_TIMERS_PER_DOW] = { //128bytes
 	{ BOOT_ON1, BOOT_OFF1, BOOT_ON2, BOOT_OFF2, 0x2FFF, 0x1FFF, 0x2FFF, 0x1FFF }
 };
 
-uint8_t EEPROM ee_reserved2_60 [60] = {
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+/* eeprom address 0x084 */
+uint8_t EEPROM ee_valve_curve[VALVE_CURVE_SIZE] = {
+	VALVE_CURVE_LINEAR,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff
+};
+
+/* eeprom address 0x08f */
+uint8_t EEPROM ee_preheat_rate[PREHEAT_RATE_SIZE] = {
 	0xff, 0xff, 0xff, 0xff
 };
 
-;                                       // reserved for future
+/* eeprom address 0x093 */
+uint8_t EEPROM ee_checkpoint[CHECKPOINT_N][CHECKPOINT_SIZE] = {
+	{ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	{ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	{ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	{ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	{ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }
+};
+
+/* eeprom address 0x0bb, OTA_EE_DESC */
+uint8_t EEPROM ee_ota[60 - VALVE_CURVE_SIZE - PREHEAT_RATE_SIZE - CHECKPOINT_N * CHECKPOINT_SIZE] = {
+	0xff, 0xff, 0xff, 0xff, 0xff
+};
 
 uint8_t EEPROM ee_config[][4] = {       // must be alligned to 4 bytes
 // order on this table depend to config_t
@@ -289,6 +346,28 @@ uint8_t EEPROM ee_config[][4] = {       // must be alligned to 4 bytes
 	//                                                                                                                      1 = tuning mode on (wide, low data rate)
  #endif
 #endif
+	/*    */ {                     5,                     5,        0,                        60 }, //!< motor_move_interval; minimal time between two valve moves [minutes]
+	/*    */ {                     2,                     2,        0,                        50 }, //!< motor_move_min; smaller valve corrections are merged [%]
+	/*    */ {                   100,                   100,        0,                       255 }, //!< motor_travel_budget; maximal valve travel per hour [%], 0 = unlimited
+	/*    */ {                   120,                   120,        0,                       255 }, //!< preheat_max; maximal optimal start before timer [minutes], 0 = disabled
+	/*    */ {                    10,                    10,        0,                       255 }, //!< lcd_idle_timeout; LCD power save after minutes without keys, 0 = disabled
+	/*    */ {                     0,                     0,        0,                         2 }, //!< lcd_idle_mode; LCD power save: 0 = low frame rate, 1 = blank with heartbeat, 2 = LCD off
+	/*    */ {                   150,                   150,        1,                       255 }, //!< energy_cpu; current of awake CPU [10uA]
+	/*    */ {                    40,                    40,        1,                       255 }, //!< energy_motor; current of running motor [mA]
+	/*    */ {                    12,                    12,        1,                       255 }, //!< energy_rfm_rx; current of RFM receiver [mA]
+	/*    */ {                    23,                    23,        1,                       255 }, //!< energy_rfm_tx; current of RFM transmitter [mA]
+	/*    */ {                    40,                    40,        1,                       255 }, //!< energy_adc; current of ADC and temperature sensor [10uA]
+	/*    */ {                    10,                    10,        0,                       255 }, //!< energy_lcd; current of LCD [uA]
+	/*    */ {                     5,                     5,        0,                       255 }, //!< energy_base; sleep current of whole device [uA]
+	/*    */ {                    24,                    24,        1,                       255 }, //!< bat_capacity; battery capacity for life projection [100mAh]
+};
+
+// journal is behind ee_config, address depends to config_t
+uint8_t EEPROM ee_journal[JOURNAL_N][2] = {
+	{ 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff },
+	{ 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff },
+	{ 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff },
+	{ 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff }, { 0xff, 0xff }
 };
 
 #endif //__EEPROM_C__
@@ -317,7 +396,12 @@ extern uint16_t timers_patch_data;
 #define CONFIG_MIN 2
 #define CONFIG_MAX 3
 
+#if EEPROM_JOURNAL
+uint8_t eeprom_config_value(uint8_t idx);
+#define config_value(i) (eeprom_config_value(i))
+#else
 #define config_value(i) (config_read((i), CONFIG_VALUE))
+#endif
 #define config_default(i) (config_read((i), CONFIG_DEFAULT))
 #define config_min(i) (config_read((i), CONFIG_MIN))
 #define config_max(i) (config_read((i), CONFIG_MAX))
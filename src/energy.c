@@ -0,0 +1,232 @@
+/*
+ *  Open HR20
+ *
+ *  target:     ATmega169 @ 4 MHz in Honnywell Rondostat HR20E
+ *
+ *  compiler:   WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file       energy.c
+ * \brief      estimate of consumed battery charge and projected battery life
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ *
+ * On time of every subsystem is integrated by timer2 (1/256 s) between
+ * marks before and after sleep, state of subsystem is sampled on mark.
+ * Short wakeups are shorter than one tick, but they are started
+ * independently of timer2 phase, so the sum is correct on average.
+ * Every minute on times are multiplied by currents from config
+ * (energy_cpu .. energy_base) and added to consumed charge.
+ *
+ * Counters are kept in .noinit and survive reset by watchdog or reboot
+ * command. Power loss (battery change) destroys the check byte, reset
+ * with higher battery voltage than before is also taken as new battery.
+ */
+
+// AVR LibC includes
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+// HR20 Project includes
+#include "config.h"
+#include "main.h"
+#include "adc.h"
+#include "motor.h"
+#include "eeprom.h"
+#include "energy.h"
+
+#if RFM
+#include "common/rfm.h"
+#endif
+
+uint16_t energy_mAh = 0;
+uint16_t energy_days_left = ENERGY_DAYS_UNKNOWN;
+
+#if ENERGY_COUNTER
+
+#define ENERGY_TICKS_SHIFT 8            //!< timer2 ticks per second = 1 << ENERGY_TICKS_SHIFT
+#define ENERGY_UAS_PER_UAH 3600UL
+
+typedef struct
+{
+	uint32_t uAh;                   //!< consumed charge [uAh]
+	uint32_t minutes;               //!< time since battery change
+	uint16_t uAs;                   //!< rest of charge [uAs], < ENERGY_UAS_PER_UAH
+	int16_t bat;                    //!< last bat_average [mV]
+	uint8_t check;
+} energy_keep_t;
+
+static energy_keep_t energy_keep __attribute__((section(".noinit")));
+
+static uint16_t energy_ticks[ENERGY_N]; //!< on time in current minute [1/256 s]
+static uint8_t energy_on = 0;           //!< subsystems on since last mark
+static uint8_t energy_t2 = 0;           //!< TCNT2 of last mark
+static bool energy_boot = true;         //!< first battery check after reset pending
+
+//! unit of current in config, energy_cpu .. energy_lcd [uA]
+static const uint16_t energy_unit[ENERGY_N] PROGMEM = {
+	/* ENERGY_CPU */ 10,
+	/* ENERGY_MOTOR */ 1000,
+	/* ENERGY_RFM_RX */ 1000,
+	/* ENERGY_RFM_TX */ 1000,
+	/* ENERGY_ADC */ 10,
+	/* ENERGY_LCD */ 1,
+};
+
+/*!
+ *******************************************************************************
+ *  check byte of kept counters
+ ******************************************************************************/
+static uint8_t energy_check(void)
+{
+	uint8_t i, c = 0xa5;
+
+	for (i = 0; i < sizeof(energy_keep_t) - 1; i++)
+	{
+		c = (c << 1) + (c >> 7) + ((uint8_t *)&energy_keep)[i];
+	}
+	return c;
+}
+
+/*!
+ *******************************************************************************
+ *  restore counters after reset or start new battery
+ ******************************************************************************/
+void ENERGY_init(void)
+{
+	if (energy_keep.check != energy_check())
+	{
+		energy_keep.uAh = 0;
+		energy_keep.minutes = 0;
+		energy_keep.uAs = 0;
+		energy_keep.bat = 0;
+		energy_keep.check = energy_check();
+	}
+	energy_mAh = energy_keep.uAh / 1000;
+	energy_t2 = TCNT2;
+}
+
+/*!
+ *******************************************************************************
+ *  integrate on times since last mark, sample state of subsystems
+ *  \param cpu_on CPU stays awake or in idle mode
+ *  \note called with interrupts disabled before sleep and after wakeup,
+ *        timer2 overflow wakes CPU every second, so 8 bit difference is enough
+ ******************************************************************************/
+void ENERGY_mark(bool cpu_on)
+{
+	uint8_t t2 = TCNT2;
+	uint8_t dt = t2 - energy_t2;
+	uint8_t on = energy_on;
+	uint8_t i;
+
+	energy_t2 = t2;
+	for (i = 0; on != 0; i++, on >>= 1)
+	{
+		if (on & 1)
+		{
+			energy_ticks[i] += dt;
+		}
+	}
+
+	on = cpu_on ? _BV(ENERGY_CPU) : 0;
+	if (MOTOR_Dir != stop)
+	{
+		on |= _BV(ENERGY_MOTOR);
+	}
+#if RFM
+	if (rfm_mode >= rfmmode_rx)
+	{
+		on |= _BV(ENERGY_RFM_RX);
+	}
+	else if (rfm_mode != rfmmode_stop)
+	{
+		on |= _BV(ENERGY_RFM_TX);
+	}
+#endif
+	if (ADCSRA & _BV(ADEN))
+	{
+		on |= _BV(ENERGY_ADC);
+	}
+	if (LCDCRA & _BV(LCDEN))
+	{
+		on |= _BV(ENERGY_LCD);
+	}
+	energy_on = on;
+}
+
+/*!
+ *******************************************************************************
+ *  add charge of last minute, update projection
+ ******************************************************************************/
+void ENERGY_minute(void)
+{
+	uint32_t uAs;
+	uint32_t hours;
+	uint8_t i;
+
+	if (energy_boot && (bat_average > 0))
+	{
+		energy_boot = false;
+		if ((energy_keep.bat != 0) && (bat_average > energy_keep.bat + ENERGY_BAT_NEW))
+		{
+			energy_keep.uAh = 0;
+			energy_keep.minutes = 0;
+			energy_keep.uAs = 0;
+		}
+	}
+
+	uAs = 60UL * config.energy_base;
+	for (i = 0; i < ENERGY_N; i++)
+	{
+		uAs += ((uint32_t)energy_ticks[i] * ((uint32_t)(&config.energy_cpu)[i] * pgm_read_word(&energy_unit[i])))
+		       >> ENERGY_TICKS_SHIFT;
+		energy_ticks[i] = 0;
+	}
+	uAs += energy_keep.uAs;
+	energy_keep.uAh += uAs / ENERGY_UAS_PER_UAH;
+	energy_keep.uAs = uAs % ENERGY_UAS_PER_UAH;
+	energy_keep.minutes++;
+	if (bat_average > 0)
+	{
+		energy_keep.bat = bat_average;
+	}
+	energy_keep.check = energy_check();
+
+	energy_mAh = energy_keep.uAh / 1000;
+	hours = energy_keep.minutes / 60;
+	energy_days_left = ENERGY_DAYS_UNKNOWN;
+	if ((hours >= ENERGY_PROJECTION_HOURS) && (energy_keep.uAh != 0))
+	{
+		uint32_t capacity = config.bat_capacity * 100000UL;     // [uAh]
+		uint32_t per_day = energy_keep.uAh / hours * 24;
+		uint32_t days;
+
+		if (per_day != 0)
+		{
+			days = (capacity > energy_keep.uAh) ? ((capacity - energy_keep.uAh) / per_day) : 0;
+			energy_days_left = (days < ENERGY_DAYS_MAX) ? days : ENERGY_DAYS_MAX;
+		}
+	}
+}
+#endif
@@ -0,0 +1,61 @@
+/*
+ *  Open HR20
+ *
+ *  target:     ATmega169 @ 4 MHz in Honnywell Rondostat HR20E
+ *
+ *  compiler:   WinAVR-20071221
+ *              avr-libc 1.6.0
+ *              GCC 4.2.2
+ *
+ *  copyright:  2008 Jiri Dobry (jdobry-at-centrum-dot-cz)
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file       energy.h
+ * \brief      estimate of consumed battery charge and projected battery life
+ * \author     Jiri Dobry <jdobry-at-centrum-dot-cz>
+ * \date       $Date$
+ * $Rev$
+ */
+
+#pragma once
+
+#define ENERGY_DAYS_UNKNOWN 0xffff
+#define ENERGY_DAYS_MAX 9999    //!< limit of projection, about 27 years
+
+// watch() entries, valid also without ENERGY_COUNTER
+extern uint16_t energy_mAh;             //!< consumed charge since battery change [mAh]
+extern uint16_t energy_days_left;       //!< projected battery life [days], ENERGY_DAYS_UNKNOWN
+
+#if ENERGY_COUNTER
+
+/* subsystems, bit in on mask and index of current in config (energy_cpu ..) */
+#define ENERGY_CPU 0            //!< CPU awake (also idle mode)
+#define ENERGY_MOTOR 1
+#define ENERGY_RFM_RX 2
+#define ENERGY_RFM_TX 3
+#define ENERGY_ADC 4            //!< ADC and temperature sensor
+#define ENERGY_LCD 5
+#define ENERGY_N 6
+
+#define ENERGY_PROJECTION_HOURS 24      //!< first projection after one day, startup calibration of motor is averaged out
+#define ENERGY_BAT_NEW 100              //!< [mV] voltage step after reset which means new battery
+
+void ENERGY_init(void);
+void ENERGY_mark(bool cpu_on);
+void ENERGY_minute(void);
+
+#endif
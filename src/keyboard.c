@@ -55,6 +55,35 @@ uint16_t kb_events = 0;
 volatile bool kb_timeout = true;
 static bool allow_rewoke = false;
 
+#if KEYBOARD_QUEUE
+// single producer (PCINT1 interrupt) single consumer (menu) ring
+// kb_queue_head is written only by interrupt, kb_queue_tail only by main loop
+static kb_queue_t kb_queue[KB_QUEUE_SIZE];
+static volatile uint8_t kb_queue_head = 0;
+static volatile uint8_t kb_queue_tail = 0;
+static volatile uint8_t kb_wheel_sec = 0xff;   //!< seconds from last wheel step, 0xff = saturated
+
+/*!
+ *******************************************************************************
+ *  Get oldest wheel step from queue
+ *
+ *  \param *e step event and time
+ *  \returns false if queue is empty
+ ******************************************************************************/
+bool kb_queue_pop(kb_queue_t *e)
+{
+	uint8_t t = kb_queue_tail;
+
+	if (t == kb_queue_head)
+	{
+		return false;
+	}
+	*e = kb_queue[t];
+	kb_queue_tail = (t + 1) & (KB_QUEUE_SIZE - 1);
+	return true;
+}
+#endif
+
 
 /*!
  *******************************************************************************
@@ -64,6 +93,13 @@ static bool allow_rewoke = false;
  ******************************************************************************/
 void task_keyboard(void)
 {
+#if KEYBOARD_QUEUE
+	if (kb_queue_tail != kb_queue_head)     // wheel, steps are decoded in interrupt
+	{
+		kb_events |= kb_queue[(kb_queue_head - 1) & (KB_QUEUE_SIZE - 1)].event;
+		long_quiet = 0;
+	}
+#else
 	{                                                       // wheel
 		uint8_t wheel = keys & (KBI_ROT1 | KBI_ROT2);
 		if ((wheel ^ state_wheel_prev) & KBI_ROT1)      //only ROT1 have interrupt, change detection
@@ -89,6 +125,7 @@ void task_keyboard(void)
 			state_wheel_prev = wheel;
 		}
 	} // wheel
+#endif
 	{ // other keys
 		uint8_t front = keys & (KBI_PROG | KBI_C | KBI_AUTO);
 		if (front != state_front_prev)
@@ -155,6 +192,14 @@ void task_keyboard(void)
  ******************************************************************************/
 void task_keyboard_long_press_detect(void)
 {
+#if KEYBOARD_QUEUE
+	cli();
+	if (kb_wheel_sec != 0xff)
+	{
+		kb_wheel_sec++;
+	}
+	sei();
+#endif
 	if (!state_front_prev)
 	{
 		if (++long_quiet == 0)
@@ -269,4 +314,28 @@ ISR(PCINT1_vect)
 	// low active
 
 	disable_rot2_input();
+#if KEYBOARD_QUEUE
+	{
+		uint8_t wheel = keys & (KBI_ROT1 | KBI_ROT2);
+		if ((wheel ^ state_wheel_prev) & KBI_ROT1)      //only ROT1 have interrupt, change detection
+		{
+			uint8_t h = kb_queue_head;
+			uint8_t next = (h + 1) & (KB_QUEUE_SIZE - 1);
+			if (next != kb_queue_tail)              // full queue drops step
+			{
+#ifdef LCD_UPSIDE_DOWN
+				kb_queue[h].event = ((wheel == 0) || (wheel == (KBI_ROT1 | KBI_ROT2)))
+						    ? KB_EVENT_WHEEL_PLUS : KB_EVENT_WHEEL_MINUS;
+#else
+				kb_queue[h].event = ((wheel == 0) || (wheel == (KBI_ROT1 | KBI_ROT2)))
+						    ? KB_EVENT_WHEEL_MINUS : KB_EVENT_WHEEL_PLUS;
+#endif
+				kb_queue[h].time = ((uint16_t)kb_wheel_sec << 8) | RTC_s256;
+				kb_wheel_sec = 0;
+				kb_queue_head = next;
+			}
+			state_wheel_prev = wheel;
+		}
+	}
+#endif
 }
@@ -76,6 +76,20 @@ extern uint16_t kb_events;
 
 extern uint8_t state_wheel_prev;
 void task_keyboard(void);
+#if KEYBOARD_QUEUE
+#define KB_QUEUE_SIZE 8         //!< must be power of 2
+#define KB_WHEEL_FAST 32        //!< step interval for wheel acceleration, unit is 1/256s
+#define KB_WHEEL_FASTER 12      //!< step interval for maximal wheel acceleration
+
+/*! wheel step from PCINT1 interrupt */
+typedef struct
+{
+	uint8_t event;  //!< KB_EVENT_WHEEL_PLUS or KB_EVENT_WHEEL_MINUS
+	uint16_t time;  //!< RTC_s256 at step, high byte: seconds from previous step
+} kb_queue_t;
+
+bool kb_queue_pop(kb_queue_t *e);
+#endif
 void task_keyboard_long_press_detect(void);
 bool mont_contact_pooling(void);
 
@@ -74,6 +74,9 @@ volatile uint8_t LCD_used_bitplanes = 1; //!< \brief number of used bitplanes /
 //! segment data for the segment registers in each bitplane
 volatile uint8_t LCD_Data[LCD_BITPLANES][LCD_REGISTER_COUNT];
 
+//! shadow frame, all drawing functions write here, \ref LCD_Update copy changes to \ref LCD_Data
+static uint8_t LCD_Shadow[LCD_BITPLANES][LCD_REGISTER_COUNT];
+
 #ifdef LCD_UPSIDE_DOWN
 #define LCD_upside_down 1
 #else
@@ -271,7 +274,33 @@ const uint8_t LCD_SegHourBarOffsetTablePrgMem[] PROGMEM =
 };
 
 
-static void LCD_calc_used_bitplanes(uint8_t mode);
+static void LCD_calc_used_bitplanes(void);
+
+#ifdef HR25
+// LCD Frame Rate Register
+//   - LCD Prescaler Select N=16       @32.768Hz ->   2048Hz
+//   - LCD Duty Cycle 1/4 (K=8)       2048Hz / 8 ->    256Hz
+//   - LCD Clock Divider  (D=5)        256Hz / 5 ->   51,2Hz
+#define LCD_FRR_NORMAL ((1 << LCDCD2))
+// low power:
+//   - LCD Prescaler Select N=64       @32.768Hz ->    512Hz
+//   - LCD Duty Cycle 1/4 (K=8)        512Hz / 8 ->     64Hz
+//   - LCD Clock Divider  (D=2)         64Hz / 2 ->     32Hz
+#define LCD_FRR_LOW ((1 << LCDPS0) | (1 << LCDCD0))
+#else
+// LCD Frame Rate Register
+//   - LCD Prescaler Select N=16       @32.768Hz ->   2048Hz
+//   - LCD Duty Cycle 1/3 (K=6)       2048Hz / 6 -> 341,33Hz
+//   - LCD Clock Divider  (D=7)     341,33Hz / 7 ->  47,76Hz
+#define LCD_FRR_NORMAL ((1 << LCDCD2) | (1 << LCDCD1))
+// low power:
+//   - LCD Prescaler Select N=64       @32.768Hz ->    512Hz
+//   - LCD Duty Cycle 1/3 (K=6)        512Hz / 6 ->  85,33Hz
+//   - LCD Clock Divider  (D=3)      85,33Hz / 3 ->  28,44Hz
+#define LCD_FRR_LOW ((1 << LCDPS0) | (1 << LCDCD1))
+#endif
+
+uint8_t LCD_power = LCD_POWER_NORMAL;
 
 /*!
  *******************************************************************************
@@ -295,33 +324,27 @@ void LCD_Init(void)
 	//   - COM0:2 connected
 	//   - SEG0:22 connected
 	LCDCRB = (1 << LCDCS) | (1 << LCDMUX1) | (1 << LCDMUX0) | (1 << LCDPM2) | (1 << LCDPM0);
-	// LCD Frame Rate Register
-	//   - LCD Prescaler Select N=16       @32.768Hz ->   2048Hz
-	//   - LCD Duty Cycle 1/4 (K=8)       2048Hz / 8 ->    256Hz
-	//   - LCD Clock Divider  (D=5)        256Hz / 5 ->   51,2Hz
-	LCDFRR = ((1 << LCDCD2));
 #else
 	// LCD Control and Status Register B
 	//   - clock source is TOSC1 pin
 	//   - COM0:3 connected
 	//   - SEG0:22 connected
 	LCDCRB = (1 << LCDCS) | (1 << LCDMUX1) | (1 << LCDPM2) | (1 << LCDPM0);
-	// LCD Frame Rate Register
-	//   - LCD Prescaler Select N=16       @32.768Hz ->   2048Hz
-	//   - LCD Duty Cycle 1/3 (K=6)       2048Hz / 6 -> 341,33Hz
-	//   - LCD Clock Divider  (D=7)     341,33Hz / 7 ->  47,76Hz
-	LCDFRR = ((1 << LCDCD2) | (1 << LCDCD1));
 #endif
+	LCDFRR = LCD_FRR_NORMAL;
+	LCD_power = LCD_POWER_NORMAL;
 
 	// LCD Control and Status Register A
 	//  - Enable LCD
 	//  - Set Low Power Waveform
 	LCDCRA = (1 << LCDEN) | (1 << LCDAB);
 
+	// copy cleared shadow frame
+	LCD_Update();
+
 	// Enable LCD start of frame interrupt
 	LCDCRA |= (1 << LCDIE);
-
-	LCD_used_bitplanes = 1;
+	LCD_force_update = 1;
 }
 
 
@@ -341,10 +364,8 @@ void LCD_AllSegments(uint8_t mode)
 
 	for (i = 0; i < LCD_REGISTER_COUNT * LCD_BITPLANES; i++)
 	{
-		((uint8_t *)LCD_Data)[i] = val;
+		((uint8_t *)LCD_Shadow)[i] = val;
 	}
-	LCD_used_bitplanes = 1;
-	LCD_Update();
 }
 
 /*!
@@ -755,22 +776,22 @@ void LCD_SetSegReg(uint8_t r, uint8_t b, uint8_t mode)
 	if (mode & 1)
 	{
 		// Set Bit in Bitplane if ON (0b11) or Blinkmode 1 (0b01)
-		LCD_Data[0][r] |= b;
+		LCD_Shadow[0][r] |= b;
 	}
 	else
 	{
 		// Clear Bit in Bitplane if OFF (0b00) or Blinkmode 2 (0b10)
-		LCD_Data[0][r] &= ~b;
+		LCD_Shadow[0][r] &= ~b;
 	}
 	if (mode & 2)
 	{
 		// Set Bit in Bitplane if ON (0b11) or Blinkmode 2 (0b10)
-		LCD_Data[1][r] |= b;
+		LCD_Shadow[1][r] |= b;
 	}
 	else
 	{
 		// Clear Bit in Bitplane if OFF (0b00) or Blinkmode 1 (0b01)
-		LCD_Data[1][r] &= ~b;
+		LCD_Shadow[1][r] &= ~b;
 	}
 
 #else
@@ -781,42 +802,59 @@ void LCD_SetSegReg(uint8_t r, uint8_t b, uint8_t mode)
 			if (mode & (1 << bp))
 			{
 				// Set Bit in Bitplane if ON (0b11) or Blinkmode 1 (0b01)
-				LCD_Data[bp][r] |= b;
+				LCD_Shadow[bp][r] |= b;
 			}
 			else
 			{
 				// Clear Bit in Bitplane if OFF (0b00) or Blinkmode 2 (0b10)
-				LCD_Data[bp][r] &= ~b;
+				LCD_Shadow[bp][r] &= ~b;
 			}
 		}
 	}
 #endif
-	LCD_calc_used_bitplanes(mode);
 }
 
 /*!
  *******************************************************************************
- *  Calculate used bitplanes
+ *  Copy shadow frame to LCD_Data
  *
- *	\note used only for update LCD, in any other cases intterupt is disabled
- *  \note copy LCD_Data to LCDREG
+ *  \note LCD interrupt is enabled only if some register is changed,
+ *        unchanged screen does not wake up CPU on LCD frame
  *
  ******************************************************************************/
-static void LCD_calc_used_bitplanes(uint8_t mode)
+void LCD_Update(void)
 {
 	uint8_t i;
+	bool changed = false;
 
-	if ((mode == LCD_MODE_BLINK_1) || (mode == LCD_MODE_BLINK_2))
+	for (i = 0; i < LCD_REGISTER_COUNT * LCD_BITPLANES; i++)
 	{
-		LCD_used_bitplanes = 2;
-		return; // just optimalization
+		uint8_t d = ((uint8_t *)LCD_Shadow)[i];
+		if (((uint8_t *)LCD_Data)[i] != d)
+		{
+			((uint8_t *)LCD_Data)[i] = d;
+			changed = true;
+		}
 	}
-	// mode must be LCD_MODE_ON or LCD_MODE_OFF
-	if (LCD_used_bitplanes == 1)
+	if (changed)
 	{
-		return; // just optimalization, nothing to do
-
+		LCD_calc_used_bitplanes();
+		LCD_force_update = 1;
+		LCDCRA |= (1 << LCDIE);
 	}
+}
+
+/*!
+ *******************************************************************************
+ *  Calculate used bitplanes
+ *
+ *	\note blinking need both bitplanes, otherwise LCD interrupt can be disabled
+ *
+ ******************************************************************************/
+static void LCD_calc_used_bitplanes(void)
+{
+	uint8_t i;
+
 	for (i = 0; i < LCD_REGISTER_COUNT; i++)
 	{
 #if LCD_BITPLANES != 2
@@ -853,7 +891,20 @@ uint8_t LCD_force_update = 0;           //!< \brief force update LCD
  ******************************************************************************/
 void task_lcd_update(void)
 {
-	if (++LCD_BlinkCounter > LCD_BLINK_FRAMES)
+	if (LCD_power == LCD_POWER_OFF)
+	{
+		// switch off started by LCD_SetPower, one step per start of frame
+		if (LCDCRA & (1 << LCDBL))
+		{
+			LCDCRA = (1 << LCDAB);  // blanked frame is done, disable
+		}
+		else if (LCDCRA & (1 << LCDEN))
+		{
+			LCDCRA |= (1 << LCDBL);
+		}
+		return;
+	}
+	if ((LCD_power == LCD_POWER_NORMAL) && (++LCD_BlinkCounter > LCD_BLINK_FRAMES))
 	{
 #if LCD_BITPLANES == 2
 		// optimized version for LCD_BITPLANES == 2
@@ -888,14 +939,61 @@ void task_lcd_update(void)
 
 
 
-	if (LCD_used_bitplanes == 1)
+	if ((LCD_used_bitplanes == 1) || (LCD_power != LCD_POWER_NORMAL))
 	{
-		// only one bitplane used, no blinking
+		// only one bitplane used, no blinking or slow blink by LCD_BlinkTick
 		// Updated; disable LCD start of frame interrupt
 		LCDCRA &= ~(1 << LCDIE);
 	}
 }
 
+/*!
+ *******************************************************************************
+ *  Set LCD power level
+ *
+ *  \param level \ref LCD_POWER_NORMAL, \ref LCD_POWER_SLOW_BLINK,
+ *               \ref LCD_POWER_LOW, \ref LCD_POWER_OFF
+ *  \note low power waveform (LCDAB) is used on all levels
+ *  \note LCD_POWER_OFF follows datasheet sequence: blank at start of frame,
+ *        disable after blanked frame; steps are done by task_lcd_update
+ ******************************************************************************/
+void LCD_SetPower(uint8_t level)
+{
+	if (level == LCD_power)
+	{
+		return;
+	}
+	LCD_power = level;
+	if (level == LCD_POWER_OFF)
+	{
+		// old LCDIF and task are cleared, next start of frame begins sequence
+		LCDCRA = (1 << LCDEN) | (1 << LCDAB) | (1 << LCDIF) | (1 << LCDIE);
+		task &= ~TASK_LCD;
+		return;
+	}
+	LCDFRR = (level == LCD_POWER_LOW) ? LCD_FRR_LOW : LCD_FRR_NORMAL;
+	LCD_force_update = 1;
+	// LCDBL can be left by unfinished switch off
+	LCDCRA = (1 << LCDEN) | (1 << LCDAB) | (1 << LCDIE);
+}
+
+/*!
+ *******************************************************************************
+ *  Switch bitplane in slow blink mode
+ *
+ *  \note call it every second, LCD interrupt is enabled only for one frame
+ *        (0.5Hz blink instead of 48 interrupts per second)
+ ******************************************************************************/
+void LCD_BlinkTick(void)
+{
+	if ((LCD_power == LCD_POWER_SLOW_BLINK || LCD_power == LCD_POWER_LOW) && (LCD_used_bitplanes == 2))
+	{
+		LCD_Bitplane ^= 1;
+		LCD_force_update = 1;
+		LCDCRA |= (1 << LCDIE);
+	}
+}
+
 /*!
  *******************************************************************************
  *  LCD Interrupt Routine
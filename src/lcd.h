@@ -47,11 +47,18 @@
 #define LCD_BLINK_FRAMES      12        //!< refreshes for each frame @ 48 frames/s; 12 refreshes -> 4Hz Blink frequency
 #define LCD_BITPLANES          2        //!< \brief two bitplanes for blinking
 
+// LCD power levels for LCD_SetPower
+#define LCD_POWER_NORMAL       0        //!< normal frame rate, blink 4Hz
+#define LCD_POWER_SLOW_BLINK   1        //!< normal frame rate, blink is switched by LCD_BlinkTick every second
+#define LCD_POWER_LOW          2        //!< lower frame rate, slow blink
+#define LCD_POWER_OFF          3        //!< LCD disabled
+
 /*****************************************************************************
 *   Global Vars
 *****************************************************************************/
 extern volatile uint8_t LCD_used_bitplanes;     //!< \brief number of used bitplanes / used for power
 extern uint8_t LCD_force_update;                //!< \brief force update LCD
+extern uint8_t LCD_power;                       //!< \brief actual power level
 
 /*****************************************************************************
 *   Prototypes
@@ -77,10 +84,9 @@ void LCD_SetSegReg(uint8_t, uint8_t, uint8_t);  // Set multiple LCD Segment(s) w
 void LCD_SetHourBarSeg(uint8_t, uint8_t);       // Set HBS (0-23) (Hour-Bar-Segment)
 void LCD_HourBarBitmap(uint32_t bitmap);        // Set HBS like bitmap
 void task_lcd_update(void);
-
-#define  LCD_Update()  ((LCDCRA |= (1 << LCDIE)), (LCD_force_update = 1))
-// Update at next LCD_ISR
-// Enable LCD start of frame interrupt
+void LCD_SetPower(uint8_t level);               // Set LCD power level
+void LCD_BlinkTick(void);                       // Switch bitplane in slow blink mode, call every second
+void LCD_Update(void);                          // Copy changed registers from shadow frame, update at next LCD_ISR
 
 
 
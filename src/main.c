@@ -58,6 +58,9 @@
 #include "com.h"
 #include "common/uart.h"
 #include "controller.h"
+#include "watch.h"
+#include "bench.h"
+#include "energy.h"
 
 #if RFM
 #include "rfm_config.h"
@@ -108,6 +111,7 @@ int __attribute__ ((noreturn)) main(void)
 	if (EEPROM_read((uint16_t)&ee_layout) != EE_LAYOUT)
 	{
 		LCD_PrintStringID(LCD_STRING_EEPr, LCD_MODE_ON);
+		LCD_Update();
 		task_lcd_update();
 		for (;; )
 		{
@@ -127,6 +131,9 @@ int __attribute__ ((noreturn)) main(void)
 
 	// We should do the following once here to have valid data from the start
 
+#if BENCH
+	BENCH_run();
+#endif
 
 	/*!
 	 ****************************************************************************
@@ -142,9 +149,12 @@ int __attribute__ ((noreturn)) main(void)
 		)
 		{
 			// nothing to do, go to sleep
-			if (timer0_need_clock() || UART_need_clock())
+			if (timer0_need_clock() || UART_need_clock() || RTC_rco_need_clock())
 			{
 				SMCR = (0 << SM1) | (0 << SM0) | (1 << SE); // Idle mode
+#if ENERGY_COUNTER
+				ENERGY_mark(true);
+#endif
 			}
 			else
 			{
@@ -156,6 +166,9 @@ int __attribute__ ((noreturn)) main(void)
 				{
 					SMCR = (1 << SM1) | (1 << SM0) | (1 << SE);     // Power-save mode
 				}
+#if ENERGY_COUNTER
+				ENERGY_mark(false);
+#endif
 			}
 
 			if (sleep_with_ADC)
@@ -170,6 +183,9 @@ int __attribute__ ((noreturn)) main(void)
 			asm volatile ("sleep");
 			asm volatile ("nop");
 			DEBUG_AFTER_SLEEP();
+#if ENERGY_COUNTER
+			ENERGY_mark(true);
+#endif
 			SMCR = (1 << SM1) | (1 << SM0) | (0 << SE); // Power-save mode
 		}
 		else
@@ -188,6 +204,9 @@ int __attribute__ ((noreturn)) main(void)
 				wirelessSendDone();
 				if (reboot)
 				{
+#if CONTROLLER_CHECKPOINT
+					CTL_checkpoint_save();
+#endif
 					cli();
 					wdt_enable(WDTO_15MS);  //wd on,15ms
 					while (1)
@@ -264,8 +283,20 @@ int __attribute__ ((noreturn)) main(void)
 #endif
 				bool minute = (RTC_GetSecond() == 0);
 				CTL_update(minute);
+#if DEBUG_WATCH_TRACE
+				watch_trace_sample(false);
+#endif
 				if (minute)
 				{
+#if ENERGY_COUNTER
+					ENERGY_minute();
+#endif
+#if LCD_POWER_PROFILE
+					if (menu_idle_minute())
+					{
+						display_task = DISP_TASK_CLEAR | DISP_TASK_UPDATE;
+					}
+#endif
 					if (((CTL_error & (CTL_ERR_BATT_LOW | CTL_ERR_BATT_WARNING)) == 0)
 					    && (RTC_GetDayOfWeek() == 6)
 					    && (RTC_GetHour() == 10)
@@ -332,7 +363,17 @@ int __attribute__ ((noreturn)) main(void)
 				if (bat_average > 0)
 				{
 					MOTOR_updateCalibration(mont_contact_pooling());
-					MOTOR_Goto(valve_wanted);
+					// user, mode and window changes move at once, only PID corrections are planned
+#if PID_AUTOTUNE
+					// relay switch of auto-tuning must move at once, delay falsifies Tu
+					MOTOR_Goto(valve_wanted, CTL_valve_force || CTL_tune_running());
+#else
+					MOTOR_Goto(valve_wanted, CTL_valve_force);
+#endif
+					CTL_valve_force = false;
+#if HAS_RECALIBRATE_RCO
+					RTC_RcoCheck(temp_average, bat_average);
+#endif
 				}
 				task_keyboard_long_press_detect();
 				if ((MOTOR_Dir == stop) || (config.allow_ADC_during_motor))
@@ -343,6 +384,9 @@ int __attribute__ ((noreturn)) main(void)
 				{
 					menu_auto_update_timeout--;
 				}
+#if LCD_POWER_PROFILE
+				LCD_BlinkTick();
+#endif
 				display_task |= DISP_TASK_UPDATE;
 			}
 #if RFM
@@ -351,6 +395,13 @@ int __attribute__ ((noreturn)) main(void)
 				cli(); RTC_timer_done &= ~_BV(RTC_TIMER_RFM); sei();
 				wirelessTimer();
 			}
+#endif
+#if HAS_RECALIBRATE_RCO
+			if (RTC_timer_done & _BV(RTC_TIMER_RCO))
+			{
+				cli(); RTC_timer_done &= ~_BV(RTC_TIMER_RCO); sei();
+				RTC_RcoTimer();
+			}
 #endif
 			// do not use continue here (menu_auto_update_timeout==0)
 		}
@@ -428,7 +479,7 @@ static inline void init(void)
 	DIDR0 = 0xFF;
 
 	//! Power reduction mode
-	power_down_ADC();
+	PRR = (1 << PRTIM1) | (1 << PRSPI) | (1 << PRADC);
 
 	//! digital I/O port direction
 	DDRG = (1 << PG3) | (1 << PG4); // PG3, PG4 Motor out
@@ -494,9 +545,18 @@ static inline void init(void)
 
 	//! Initialize the RTC
 	RTC_Init();
+#if ENERGY_COUNTER
+	ENERGY_init();
+#endif
 
 	// press all keys on boot reload default eeprom values
-	eeprom_config_init((PINB & (KBI_PROG | KBI_C | KBI_AUTO)) == 0);
+	{
+		bool restore_default = ((PINB & (KBI_PROG | KBI_C | KBI_AUTO)) == 0);
+		eeprom_config_init(restore_default);
+#if CONTROLLER_CHECKPOINT
+		CTL_checkpoint_restore(restore_default);
+#endif
+	}
 
 #if RFM
 	crypto_init();
@@ -56,7 +56,8 @@ void delay(uint16_t);                   // delay
 
 extern bool reboot;
 
-#define power_up_ADC() (PRR = (1 << PRTIM1) | (1 << PRSPI))
-#define power_down_ADC() (PRR = (1 << PRTIM1) | (1 << PRSPI) | (1 << PRADC))
+// timer1 is powered only during RC oscillator recalibration, keep its PRR bit
+#define power_up_ADC() (PRR &= ~(1 << PRADC))
+#define power_down_ADC() (PRR |= (1 << PRADC))
 
 #endif /* MAIN_H */
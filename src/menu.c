@@ -103,6 +103,40 @@ typedef enum
  *
  * \returns true for controler restart
  ******************************************************************************/
+#if KEYBOARD_QUEUE
+static uint8_t wheel_time;
+
+static int8_t wheel_proccess(void)
+{
+	int8_t ret = 0;
+	kb_queue_t e;
+
+	while (kb_queue_pop(&e))
+	{
+		// wheel acceleration by time between steps, 1s and more is idle wheel
+		int8_t step = 1;
+		uint16_t dt = e.time - wheel_time;
+		if (dt < KB_WHEEL_FASTER)
+		{
+			step = 5;
+		}
+		else if (dt < KB_WHEEL_FAST)
+		{
+			step = 2;
+		}
+		wheel_time = (uint8_t)e.time;
+		if (e.event == KB_EVENT_WHEEL_MINUS)
+		{
+			step = -step;
+		}
+		if ((ret + step <= 100) && (ret + step >= -100))
+		{
+			ret += step;
+		}
+	}
+	return ret;
+}
+#else
 static int8_t wheel_proccess(void)
 {
 	int8_t ret = 0;
@@ -117,6 +151,7 @@ static int8_t wheel_proccess(void)
 	}
 	return ret;
 }
+#endif
 
 /*!
  *******************************************************************************
@@ -195,6 +230,49 @@ static bool events_common(void)
 	return ret;
 }
 
+#if LCD_POWER_PROFILE
+static uint8_t menu_idle_minutes = 0;   // minutes without key activity
+
+/*!
+ *******************************************************************************
+ * \brief LCD power profile, call it every minute
+ *
+ * \note after config.lcd_idle_timeout minutes without keys on home screen:
+ *       - without error: lower frame rate (lcd_idle_mode 0), blank display
+ *         with heartbeat (1) or LCD off (2)
+ *       - with error: error display stay visible, but blinks from 1s tick
+ *
+ * \returns true to request display update
+ ******************************************************************************/
+bool menu_idle_minute(void)
+{
+	uint8_t level = LCD_POWER_NORMAL;
+
+	if (menu_idle_minutes < 255)
+	{
+		menu_idle_minutes++;
+	}
+	if ((config.lcd_idle_timeout != 0) && (menu_idle_minutes >= config.lcd_idle_timeout)
+	    && (menu_state == menu_home))
+	{
+		if ((CTL_error != 0) || (MOTOR_calibration_step > 0))
+		{
+			level = LCD_POWER_SLOW_BLINK;
+		}
+		else
+		{
+			level = (config.lcd_idle_mode >= 2) ? LCD_POWER_OFF : LCD_POWER_LOW;
+		}
+	}
+	if (level != LCD_power)
+	{
+		LCD_SetPower(level);
+		return true;
+	}
+	return (level == LCD_POWER_LOW) && (config.lcd_idle_mode == 1); // heartbeat
+}
+#endif
+
 /*!
  *******************************************************************************
  * \brief menu Controller: state transitions in the menu state machine
@@ -203,9 +281,24 @@ static bool events_common(void)
  ******************************************************************************/
 bool menu_controller(void)
 {
-	int8_t wheel = wheel_proccess(); //signed number
+	int8_t wheel;
 	bool ret = false;
 
+#if LCD_POWER_PROFILE
+	if (kb_events & ~(KB_EVENT_NONE_LONG | KB_EVENT_UPDATE_LCD))
+	{
+		menu_idle_minutes = 0;
+		if (LCD_power != LCD_POWER_NORMAL)
+		{
+			// first key or wheel event only wakes up display
+			LCD_SetPower(LCD_POWER_NORMAL);
+			wheel_proccess();
+			kb_events = 0;
+			return true;
+		}
+	}
+#endif
+	wheel = wheel_proccess(); //signed number
 	switch (menu_state)
 	{
 	case menu_startup:
@@ -539,6 +632,14 @@ bool menu_controller(void)
 			menu_auto_update_timeout = 0;
 			ret = true;
 		}
+#if PID_AUTOTUNE
+		else if (kb_events & KB_EVENT_PROG)
+		{
+			// start / abort PID auto-tuning, state is readable by command U
+			CTL_tune(!CTL_tune_running());
+			ret = true;
+		}
+#endif
 		else
 		{
 			service_watch_n = (service_watch_n + wheel + WATCH_N) % WATCH_N;
@@ -638,6 +739,20 @@ void menu_view(bool clear)
 {
 	uint8_t lcd_blink_mode = menu_auto_update_timeout > 0 ? LCD_MODE_ON : LCD_MODE_BLINK_1;
 
+#if LCD_POWER_PROFILE
+	if (LCD_power == LCD_POWER_OFF)
+	{
+		return;
+	}
+	if ((LCD_power == LCD_POWER_LOW) && (config.lcd_idle_mode == 1))
+	{
+		// blank display, heartbeat segment changes every minute
+		LCD_AllSegments(LCD_MODE_OFF);
+		LCD_SetSeg(LCD_SEG_COL1, (RTC_GetMinute() & 1) ? LCD_MODE_ON : LCD_MODE_OFF);
+		LCD_Update();
+		return;
+	}
+#endif
 	switch (menu_state)
 	{
 	case menu_startup:
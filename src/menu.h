@@ -37,5 +37,8 @@ extern int8_t menu_auto_update_timeout;
 extern bool menu_locked;
 
 bool menu_controller(void);
+#if LCD_POWER_PROFILE
+bool menu_idle_minute(void);
+#endif
 void menu_view(bool update);
 void menu_update_hourbar(uint8_t dow);
@@ -77,6 +77,32 @@ static void MOTOR_Control(motor_dir_t); // control H-bridge of motor
 
 static uint8_t MOTOR_wait_for_new_calibration = 5;
 
+uint32_t MOTOR_run_time = 0;                    //!< total motor run time [sec]
+uint16_t MOTOR_starts = 0;                      //!< count of motor starts
+static volatile uint16_t motor_run_cnt = 0;     //!< timer0 overflows with running motor
+static uint16_t motor_run_frac = 0;
+
+static uint16_t MOTOR_plan_idle = 0xffff;       //!< time from last planned move [sec]
+static uint16_t MOTOR_plan_sec = 0;             //!< position in actual travel budget hour [sec]
+static uint16_t MOTOR_plan_travel = 0;          //!< valve travel in actual hour [impulses]
+
+#if DEBUG_MOTOR_PROFILE
+static motor_profile_t motor_profile[MOTOR_PROFILE_N];
+static uint8_t motor_profile_idx = 0;           //!< next record
+static motor_profile_t motor_prof;              //!< actual move
+static uint32_t motor_prof_ticks;               //!< timer0 overflows of actual move
+static uint32_t motor_prof_pwm_sum;
+static uint16_t motor_prof_pulses;
+
+static void MOTOR_profile_start(motor_dir_t direction);
+static void MOTOR_profile_pulse(void);
+static void MOTOR_profile_end(uint8_t reason);
+#else
+#define MOTOR_profile_start(direction)
+#define MOTOR_profile_pulse()
+#define MOTOR_profile_end(reason)
+#endif
+
 
 /*!
  *******************************************************************************
@@ -93,6 +119,7 @@ void MOTOR_updateCalibration(uint8_t cal_type)
 {
 	if (cal_type == 0)
 	{
+		MOTOR_profile_end(MOTOR_PROF_ABORT);
 		MOTOR_Control(stop);            // stop motor
 		MOTOR_PosAct = 0;               // not calibrated
 		MOTOR_PosMax = 0;               // not calibrated
@@ -103,11 +130,19 @@ void MOTOR_updateCalibration(uint8_t cal_type)
 		MOTOR_calibration_step = -2;    // not calibrated
 		MOTOR_wait_for_new_calibration = 5;
 		CTL_clear_error(CTL_ERR_MOTOR);
+#if CONTROLLER_CHECKPOINT
+		if (!CTL_checkpoint_restored)   // keep sumError and credit restored after reboot
+#endif
+		{
 #if CALIBRATION_RESETS_sumError
-		sumError = 0;         // new calibration need found new sumError
+			sumError = 0;         // new calibration need found new sumError
+#endif
+			CTL_interatorCredit = config.I_max_credit;
+		}
+#if CONTROLLER_CHECKPOINT
+		CTL_checkpoint_restored = false;
 #endif
 		CTL_integratorBlock = DEFINE_INTEGRATOR_BLOCK;
-		CTL_interatorCredit = config.I_max_credit;
 	}
 	else
 	{
@@ -168,17 +203,129 @@ uint8_t MOTOR_GetPosPercent(void)
 
 volatile uint8_t MOTOR_PosOvershoot = 0; // detected motor overshoot
 
+/*!
+ *******************************************************************************
+ * valve travel planner, decide if motor can start now
+ *
+ * \param  percent desired endposition 0-100
+ * \param  diff travel in impulses
+ * \param  force start now, travel is still counted
+ * \returns true if move is allowed
+ *
+ * \note
+ *  - every motor start costs eye, PWM spin-up and idle sleep, small
+ *    corrections are merged to one bigger move
+ *  - move is allowed after config.motor_move_interval minutes if it is
+ *    bigger than config.motor_move_min, smaller one waits MOTOR_PLAN_STALE
+ *    intervals
+ *  - travel per hour is limited by config.motor_travel_budget
+ *  - end positions (0% and 100%) are never delayed
+ *  - forced moves (setpoint change, auto-tuning) are never delayed
+ ******************************************************************************/
+#define MOTOR_PLAN_STALE 4
+static bool MOTOR_plan(uint8_t percent, int16_t diff, bool force)
+{
+	if ((percent != 0) && (percent != 100) && !force)
+	{
+		uint16_t interval = (uint16_t)config.motor_move_interval * 60;
+		if (MOTOR_plan_idle < interval)
+		{
+			return false;
+		}
+		if ((diff < ((int16_t)config.motor_move_min * (MOTOR_PosMax >> 2)) / (100 >> 2))
+		    && (MOTOR_plan_idle < interval * MOTOR_PLAN_STALE))
+		{
+			return false;
+		}
+		if ((config.motor_travel_budget != 0)
+		    && (MOTOR_plan_travel + diff >
+			((uint16_t)config.motor_travel_budget * (MOTOR_PosMax >> 2)) / (100 >> 2)))
+		{
+			return false;
+		}
+	}
+	MOTOR_plan_idle = 0;
+	MOTOR_plan_travel += diff;
+	return true;
+}
+
+/*!
+ *******************************************************************************
+ * update motor run time and planner time
+ *
+ * \note called every second from MOTOR_Goto
+ ******************************************************************************/
+static void MOTOR_timer_second(void)
+{
+	uint16_t c;
+	uint32_t t;
+
+	cli(); c = motor_run_cnt; motor_run_cnt = 0; sei();
+	t = (uint32_t)motor_run_frac + c;
+	while (t >= (F_CPU / 256))      // timer0 overflows per second
+	{
+		t -= (F_CPU / 256);
+		MOTOR_run_time++;
+	}
+	motor_run_frac = (uint16_t)t;
+
+	if (MOTOR_plan_idle != 0xffff)
+	{
+		MOTOR_plan_idle++;
+	}
+	if (++MOTOR_plan_sec >= 3600)
+	{
+		MOTOR_plan_sec = 0;
+		MOTOR_plan_travel = 0;
+	}
+}
+
+#if VALVE_CURVE
+/*!
+ *******************************************************************************
+ * valve characteristic, piecewise linear between 10% points of ee_valve_curve
+ *
+ * \param  percent flow 1-99
+ * \returns stroke in 1/10 %
+ ******************************************************************************/
+static int16_t MOTOR_curve(uint8_t percent)
+{
+	uint8_t st = EEPROM_read((uint16_t)&ee_valve_curve[0]);
+
+	if ((st == VALVE_CURVE_UPLOADED) || (st == VALVE_CURVE_LEARNED))
+	{
+		uint8_t i = percent / 10;
+		uint8_t lo = (i == 0) ? 0 : EEPROM_read((uint16_t)&ee_valve_curve[i]);
+		uint8_t hi = (i == 9) ? 100 : EEPROM_read((uint16_t)&ee_valve_curve[i + 1]);
+		if (lo > 100)
+		{
+			lo = 100;
+		}
+		if (hi > 100)
+		{
+			hi = 100;
+		}
+		return (int16_t)lo * 10 + ((int16_t)hi - (int16_t)lo) * (percent % 10);
+	}
+	return (int16_t)percent * 10;
+}
+#endif
+
 /*!
  *******************************************************************************
  * drive motor to desired position in percent
  * \param  percent desired endposition 0-100
  *         - 0 : closed
  *         - 100 : open
+ * \param  force skip MOTOR_plan delays (setpoint change, relay auto-tuning)
  *
  * \note   works only if calibrated before
+ * \note   called every second, start of motor is controlled by MOTOR_plan
+ * \note   with VALVE_CURVE percent is flow, ee_valve_curve maps it to stroke
  ******************************************************************************/
-void MOTOR_Goto(uint8_t percent)
+void MOTOR_Goto(uint8_t percent, bool force)
 {
+	MOTOR_timer_second();
 	// works only if calibrated
 	if (MOTOR_IsCalibrated() && !MOTOR_eye_test())
 	{
@@ -193,11 +340,15 @@ void MOTOR_Goto(uint8_t percent)
 		}
 		else
 		{
+#if VALVE_CURVE
+			MOTOR_PosStop = ((int32_t)MOTOR_curve(percent) * MOTOR_PosMax) / 1000;
+#else
 			// MOTOR_PosMax>>2 and 100>>2 => overload protection
 #if (MOTOR_MAX_IMPULSES >> 2) * (100 >> 2) > INT16_MAX
 #error variable OVERLOAD possible
 #endif
 			MOTOR_PosStop = ((int16_t)percent * (MOTOR_PosMax >> 2)) / (100 >> 2);
+#endif
 		}
 		// switch motor on
 		{
@@ -205,11 +356,17 @@ void MOTOR_Goto(uint8_t percent)
 			int16_t s = MOTOR_PosStop;      // volatile variable optimization
 			if (a > s + MOTOR_PosOvershoot)
 			{
-				MOTOR_Control(close);
+				if (MOTOR_plan(percent, a - s, force))
+				{
+					MOTOR_Control(close);
+				}
 			}
 			else if (a < s - MOTOR_PosOvershoot)
 			{
-				MOTOR_Control(open);
+				if (MOTOR_plan(percent, s - a, force))
+				{
+					MOTOR_Control(open);
+				}
 			}
 		}
 	}
@@ -276,6 +433,7 @@ static void MOTOR_Control(motor_dir_t direction)
 	{
 		if (MOTOR_Dir != direction)
 		{
+			MOTOR_starts++;
 			MOTOR_eye_enable();
 			motor_diag_cnt = 0; last_eye_change = 0; longest_low_eye = 0;
 			motor_diag_ignore = MOTOR_IGNORE_IMPULSES;
@@ -302,6 +460,7 @@ static void MOTOR_Control(motor_dir_t direction)
 				MOTOR_pwm_set(config.motor_pwm_max);
 #endif
 			}
+			MOTOR_profile_start(direction);
 			if (direction == close)
 			{
 				// set pins of H-Bridge
@@ -364,6 +523,7 @@ void MOTOR_timer_pulse(void)
 	{
 		motor_diag_ignore--;
 	}
+	MOTOR_profile_pulse();
 
 #if DEBUG_PRINT_MOTOR
 	COM_debug_print_motor(MOTOR_Dir, motor_diag, OCR0A);
@@ -381,6 +541,9 @@ void MOTOR_timer_stop(void)
 {
 	motor_dir_t d = MOTOR_Dir;
 
+	MOTOR_profile_end((motor_timer > 0)
+			  ? ((MOTOR_calibration_step != 0) ? MOTOR_PROF_ERR : MOTOR_PROF_POS)
+			  : MOTOR_PROF_END);
 	MOTOR_Control(stop);
 	if (motor_timer > 0)                            // normal stop on wanted position
 	{
@@ -465,6 +628,117 @@ void MOTOR_timer_stop(void)
 	}
 }
 
+#if DEBUG_MOTOR_PROFILE
+/*!
+ *******************************************************************************
+ * motor profile, start of move
+ *
+ * \note called from MOTOR_Control after PWM startup value is set
+ ******************************************************************************/
+static void MOTOR_profile_start(motor_dir_t direction)
+{
+	uint8_t i;
+
+	motor_prof.seq = (uint8_t)MOTOR_starts;
+	motor_prof.flags = MOTOR_PROF_ACTIVE | ((direction == open) ? MOTOR_PROF_OPEN : 0);
+	motor_prof.pos_start = MOTOR_PosAct;
+	motor_prof.pwm_start = OCR0A;
+	motor_prof.pwm_min = OCR0A;
+	motor_prof.pwm_max = OCR0A;
+	for (i = 0; i < 4; i++)
+	{
+		motor_prof.hist[i] = 0;
+	}
+	motor_prof_ticks = 0;
+	motor_prof_pwm_sum = 0;
+	motor_prof_pulses = 0;
+}
+
+/*!
+ *******************************************************************************
+ * motor profile, one eye pulse
+ *
+ * \note called from MOTOR_timer_pulse after PWM update
+ ******************************************************************************/
+static void MOTOR_profile_pulse(void)
+{
+	uint16_t d = motor_diag;
+	uint16_t t = (uint16_t)config.motor_speed << 3;
+	uint8_t pwm = OCR0A;
+	uint8_t h;
+
+	motor_prof_ticks += d;
+	motor_prof_pwm_sum += pwm;
+	motor_prof_pulses++;
+	if (pwm < motor_prof.pwm_min)
+	{
+		motor_prof.pwm_min = pwm;
+	}
+	if (pwm > motor_prof.pwm_max)
+	{
+		motor_prof.pwm_max = pwm;
+	}
+	if (d < t - (t >> 2))
+	{
+		h = 0;
+	}
+	else if (d < t)
+	{
+		h = 1;
+	}
+	else if (d < t + (t >> 2))
+	{
+		h = 2;
+	}
+	else
+	{
+		h = 3;
+	}
+	if (motor_prof.hist[h] != 0xff)
+	{
+		motor_prof.hist[h]++;
+	}
+}
+
+/*!
+ *******************************************************************************
+ * motor profile, end of move, store it to ring
+ *
+ * \param reason MOTOR_PROF_POS, MOTOR_PROF_END, MOTOR_PROF_ERR or MOTOR_PROF_ABORT
+ ******************************************************************************/
+static void MOTOR_profile_end(uint8_t reason)
+{
+	uint16_t tail;
+
+	if ((motor_prof.flags & MOTOR_PROF_ACTIVE) == 0)
+	{
+		return;
+	}
+	cli(); tail = motor_diag_cnt; sei();
+	motor_prof_ticks += tail;
+	motor_prof.flags = (motor_prof.flags & MOTOR_PROF_OPEN) | reason;
+	motor_prof.pos_stop = MOTOR_PosAct;
+	motor_prof.duration = ((motor_prof_ticks >> 8) > 0xffff) ? 0xffff : (uint16_t)(motor_prof_ticks >> 8);
+	motor_prof.pwm_avg = (motor_prof_pulses != 0)
+			     ? (uint8_t)(motor_prof_pwm_sum / motor_prof_pulses)
+			     : motor_prof.pwm_start;
+	motor_profile[motor_profile_idx] = motor_prof;
+	motor_profile_idx = (motor_profile_idx + 1) & (MOTOR_PROFILE_N - 1);
+}
+
+/*!
+ *******************************************************************************
+ * get recorded motor move
+ *
+ * \param idx 0 = last move, 1 = previous move ...
+ * \returns record, unused records are zero
+ ******************************************************************************/
+const motor_profile_t *MOTOR_profile_get(uint8_t idx)
+{
+	return &motor_profile[(uint8_t)(motor_profile_idx - 1 - idx) & (MOTOR_PROFILE_N - 1)];
+}
+#endif
+
 // interrupts:
 
 /*!
@@ -571,6 +845,10 @@ ISR(TIMER0_OVF_vect)
 	}
 	else
 	{
+		if (MOTOR_run_test())
+		{
+			motor_run_cnt++;
+		}
 		if (motor_timer > 0)
 		{
 			motor_timer--;
@@ -33,6 +33,8 @@
 
 #pragma once
 
+#include "debug.h"
+
 /*****************************************************************************
 *   Macros
 *****************************************************************************/
@@ -102,7 +104,7 @@ typedef enum
 *   Prototypes
 *****************************************************************************/
 #define MOTOR_Init(void) (MOTOR_updateCalibration(1))           // Init motor control
-void MOTOR_Goto(uint8_t);                                       // Goto position in percent
+void MOTOR_Goto(uint8_t, bool);                                 // Goto position in percent
 #define MOTOR_IsCalibrated() (MOTOR_calibration_step == 0)      // is motor successful calibrated?
 void MOTOR_updateCalibration(uint8_t cal_type);                 // reset the calibration
 uint8_t MOTOR_GetPosPercent(void);                              // get percental position of motor (0-100%)
@@ -119,3 +121,32 @@ extern uint16_t motor_diag_count;
 extern motor_dir_t MOTOR_Dir;           //!< actual direction
 extern volatile uint8_t MOTOR_PosOvershoot;
 extern uint32_t MOTOR_counter;          //!< count volume of motor pulses for dianostic
+extern uint32_t MOTOR_run_time;         //!< total motor run time [sec]
+extern uint16_t MOTOR_starts;           //!< count of motor starts
+
+#if DEBUG_MOTOR_PROFILE
+//! one motor move, sent as 16 raw bytes (little endian) by command P
+typedef struct
+{
+	uint8_t seq;            //!< low byte of MOTOR_starts
+	uint8_t flags;          //!< MOTOR_PROF_OPEN | reason
+	int16_t pos_start;      //!< MOTOR_PosAct on start
+	int16_t pos_stop;       //!< MOTOR_PosAct on stop
+	uint16_t duration;      //!< unit is 256 timer0 overflows (1/61 s)
+	uint8_t pwm_start;      //!< OCR0A after start
+	uint8_t pwm_min;
+	uint8_t pwm_max;
+	uint8_t pwm_avg;
+	uint8_t hist[4];        //!< pulse intervals <3/4, <1, <5/4, >=5/4 of motor_speed
+} motor_profile_t;
+
+#define MOTOR_PROFILE_N 4               //!< must be power of 2
+#define MOTOR_PROF_OPEN     0x01        //!< direction open
+#define MOTOR_PROF_ACTIVE   0x02        //!< move is running
+#define MOTOR_PROF_POS      (1 << 4)    //!< stopped on wanted position
+#define MOTOR_PROF_END      (2 << 4)    //!< stopped by timeout (end position)
+#define MOTOR_PROF_ERR      (3 << 4)    //!< calibration error
+#define MOTOR_PROF_ABORT    (4 << 4)    //!< valve unmounted
+
+const motor_profile_t *MOTOR_profile_get(uint8_t idx);
+#endif
@@ -40,6 +40,7 @@
 #include "controller.h"
 #include "motor.h"
 #include "watch.h"
+#include "energy.h"
 #include "debug.h"
 
 #define B8 0x0000
@@ -50,9 +51,9 @@ int16_t MOTOR_PosMax;
 
 
 #if DEBUG_MOTOR_COUNTER
-#define WATCH_LAYOUT 0x85
+#define WATCH_LAYOUT 0x87
 #else
-#define WATCH_LAYOUT 0x05
+#define WATCH_LAYOUT 0x07
 #endif
 
 
@@ -66,9 +67,14 @@ static const uint16_t watch_map[WATCH_N] PROGMEM = {
 	/* 06 */ ((uint16_t)&MOTOR_PosMax) + B16,
 	/* 07 */ ((uint16_t)&MOTOR_PosAct) + B16,
 	/* 08 */ ((uint16_t)&MOTOR_PosOvershoot) + B8,
+	/* 09 */ ((uint16_t)&MOTOR_run_time) + B16,
+	/* 0a */ ((uint16_t)&MOTOR_run_time) + 2 + B16,
+	/* 0b */ ((uint16_t)&MOTOR_starts) + B16,
+	/* 0c */ ((uint16_t)&energy_mAh) + B16,
+	/* 0d */ ((uint16_t)&energy_days_left) + B16,
 #if DEBUG_MOTOR_COUNTER
-	/* 09 */ ((uint16_t)&MOTOR_counter) + B16,
-	/* 0a */ ((uint16_t)&MOTOR_counter) + 2 + B16,
+	/* 0e */ ((uint16_t)&MOTOR_counter) + B16,
+	/* 0f */ ((uint16_t)&MOTOR_counter) + 2 + B16,
 #endif
 };
 
@@ -91,3 +97,143 @@ uint16_t watch(uint8_t addr)
 		return (uint16_t)(*((uint8_t *)(p)));
 	}
 }
+
+#if DEBUG_WATCH_TRACE
+/*
+ * trace: watch_map entries selected by mask are sampled together as one
+ * record, on every PID step or every interval seconds. Records are kept in
+ * ring, sequence number of record (8 bit) lets reader fetch them in bulk
+ * and notice lost ones.
+ */
+uint16_t watch_trace_mask = 0;
+uint8_t watch_trace_interval = 0;               //!< 0 = off, WATCH_TRACE_PID or seconds
+
+static uint16_t trace_ring[WATCH_TRACE_SIZE];
+static uint8_t trace_words;                     //!< words in record
+static uint8_t trace_records;                   //!< capacity of ring in records
+static uint8_t trace_valid;                     //!< records in ring
+static uint8_t trace_newest;                    //!< index of newest record
+static uint8_t trace_seq;                       //!< sequence number of next record
+static uint8_t trace_timer;
+
+/*!
+ *******************************************************************************
+ *  trace configuration, ring is cleared
+ *  \note sequence number continues, reader sees restart as lost records
+ ******************************************************************************/
+void watch_trace_config(uint16_t mask, uint8_t interval)
+{
+	uint8_t i;
+
+	mask &= (uint16_t)((1UL << WATCH_N) - 1);
+	trace_words = 0;
+	for (i = 0; i < WATCH_N; i++)
+	{
+		if (mask & (1U << i))
+		{
+			trace_words++;
+		}
+	}
+	if (trace_words == 0)
+	{
+		interval = 0;
+	}
+	watch_trace_mask = mask;
+	watch_trace_interval = interval;
+	trace_records = (trace_words != 0) ? (WATCH_TRACE_SIZE / trace_words) : 0;
+	trace_valid = 0;
+	trace_newest = trace_records - 1;
+	trace_timer = 0;
+}
+
+/*!
+ *******************************************************************************
+ *  trace sampling
+ *  \param pid_step true on PID step, false every second
+ ******************************************************************************/
+void watch_trace_sample(bool pid_step)
+{
+	uint8_t i;
+	uint16_t *p;
+
+	if (watch_trace_interval == 0)
+	{
+		return;
+	}
+	if (watch_trace_interval == WATCH_TRACE_PID)
+	{
+		if (!pid_step)
+		{
+			return;
+		}
+	}
+	else
+	{
+		if (pid_step || (++trace_timer < watch_trace_interval))
+		{
+			return;
+		}
+		trace_timer = 0;
+	}
+	if (++trace_newest >= trace_records)
+	{
+		trace_newest = 0;
+	}
+	p = trace_ring + trace_newest * trace_words;
+	for (i = 0; i < WATCH_N; i++)
+	{
+		if (watch_trace_mask & (1U << i))
+		{
+			*(p++) = watch(i);
+		}
+	}
+	if (trace_valid < trace_records)
+	{
+		trace_valid++;
+	}
+	trace_seq++;
+}
+
+/*!
+ *******************************************************************************
+ *  copy records from sequence number seq
+ *  \param seq wanted record, moved to oldest record in ring if it is lost
+ *  \param buf WATCH_TRACE_FETCH words
+ *  \returns number of words, whole records only
+ ******************************************************************************/
+uint8_t watch_trace_fetch(uint8_t *seq, uint16_t *buf)
+{
+	uint8_t age = trace_seq - *seq;         // records from seq to newest
+	uint8_t n = 0;
+	uint8_t r, i;
+
+	if (age > trace_valid)
+	{
+		age = trace_valid;
+		*seq = trace_seq - age;
+	}
+	if (age == 0)
+	{
+		return 0;
+	}
+	r = trace_newest + trace_records + 1 - age;
+	if (r >= trace_records)
+	{
+		r -= trace_records;
+	}
+	while ((age > 0) && (n + trace_words <= WATCH_TRACE_FETCH))
+	{
+		uint16_t *p = trace_ring + r * trace_words;
+		for (i = 0; i < trace_words; i++)
+		{
+			buf[n++] = p[i];
+		}
+		if (++r >= trace_records)
+		{
+			r = 0;
+		}
+		age--;
+	}
+	return n;
+}
+#endif
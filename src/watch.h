@@ -33,6 +33,21 @@
 
 #pragma once
 
+#include "debug.h"
+
 uint16_t watch(uint8_t addr);
 
-#define WATCH_N (11)
+#define WATCH_N (16)
+
+#if DEBUG_WATCH_TRACE
+#define WATCH_TRACE_SIZE (48)   // words in ring
+#define WATCH_TRACE_FETCH (WATCH_N) // max words in one reply of command J, one record fits
+#define WATCH_TRACE_PID (0xff)  // interval: sample on every PID step
+
+extern uint16_t watch_trace_mask;
+extern uint8_t watch_trace_interval;
+
+void watch_trace_config(uint16_t mask, uint8_t interval);
+void watch_trace_sample(bool pid_step);
+uint8_t watch_trace_fetch(uint8_t *seq, uint16_t *buf);
+#endif
@@ -0,0 +1,351 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	avrbench.c
+ * \brief	run benchmark image (src/bench.c) in simavr, count cycles of hot paths
+ *
+ * Firmware writes id of path to BENCH_MARK before call and 0 after it,
+ * cycle counter of simulator is taken on both writes. Cycles of empty
+ * frame (id 1) are subtracted. Result can be stored as baseline and later
+ * runs are compared with it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+
+#include "bench.h"
+
+#define AVRBENCH_VERSION "0.1"
+
+#define IDS 0x100
+#define CYCLE_LIMIT 200000000ULL        //!< 50 s of firmware time at 4 MHz
+#define TOLERANCE 2                     //!< % of allowed regression
+
+struct result
+{
+	unsigned calls;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+};
+
+static const char *names[IDS] =
+{
+#define BENCH_NAME(id, name) [id] = #name,
+	BENCH_LIST(BENCH_NAME)
+#undef BENCH_NAME
+};
+
+static struct result results[IDS];
+static uint8_t mark_id = 0;
+static avr_cycle_count_t mark_start;
+static int finished = 0;
+
+static struct option long_options[] =
+{
+	{"file", required_argument, 0, 'f'},
+	{"mcu", required_argument, 0, 'm'},
+	{"frequency", required_argument, 0, 'F'},
+	{"baseline", required_argument, 0, 'b'},
+	{"output", required_argument, 0, 'o'},
+	{"tolerance", required_argument, 0, 't'},
+	{"cycles", required_argument, 0, 'c'},
+	{"help", no_argument, 0, 'h'},
+	{0, 0, 0, 0}
+};
+
+static void printUsage(void)
+{
+	printf("avrbench version %s\n", AVRBENCH_VERSION);
+	printf("\nOptions:\n\n");
+	printf("--file        -f\tbenchmark image (default hr20_bench.elf)\n");
+	printf("--mcu         -m\tmcu if not stored in image (default atmega169p)\n");
+	printf("--frequency   -F\tclock in Hz (default 4000000)\n");
+	printf("--baseline    -b\tcompare with result file, fail on regression\n");
+	printf("--output      -o\twrite result file (new baseline)\n");
+	printf("--tolerance   -t\tallowed regression in %% (default %d)\n", TOLERANCE);
+	printf("--cycles      -c\tstop simulation after cycles (default %llu)\n", CYCLE_LIMIT);
+	printf("--help        -h\tthis help\n");
+}
+
+/*!
+ ********************************************************************************
+ * markWrite
+ *
+ * write to BENCH_MARK, id starts measurement, 0 ends it
+ *******************************************************************************/
+static void markWrite(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+	(void)param;
+	avr->data[addr] = v;
+	if (v == BENCH_END)
+	{
+		finished = 1;
+	}
+	else if (v != 0)
+	{
+		mark_id = v;
+		mark_start = avr->cycle;
+	}
+	else if (mark_id != 0)
+	{
+		struct result *r = &results[mark_id];
+		uint64_t c = avr->cycle - mark_start;
+
+		if ((r->calls == 0) || (c < r->min))
+			r->min = c;
+		if (c > r->max)
+			r->max = c;
+		r->sum += c;
+		r->calls++;
+		mark_id = 0;
+	}
+}
+
+/*!
+ ********************************************************************************
+ * netCycles
+ *
+ * \returns average cycles of id without empty frame
+ *******************************************************************************/
+static uint64_t netCycles(int id)
+{
+	uint64_t avg = results[id].sum / results[id].calls;
+	uint64_t empty = results[1].calls ? results[1].min : 0;
+
+	return (id == 1) ? avg : ((avg > empty) ? avg - empty : 0);
+}
+
+static const char *idName(int id)
+{
+	static char buf[8];
+
+	if (names[id] != NULL)
+		return names[id];
+	snprintf(buf, sizeof(buf), "id%d", id);
+	return buf;
+}
+
+/*!
+ ********************************************************************************
+ * writeResult
+ *
+ * one line per path: name average_cycles, same format is read as baseline
+ *
+ * \returns 1 on success
+ *******************************************************************************/
+static int writeResult(const char *file, const char *elf, uint32_t freq)
+{
+	FILE *f;
+	int id;
+
+	f = fopen(file, "w");
+	if (f == NULL)
+	{
+		perror(file);
+		return 0;
+	}
+	fprintf(f, "# avrbench %s %u Hz, average cycles without empty frame\n", elf, freq);
+	for (id = 1; id < BENCH_END; id++)
+	{
+		if (results[id].calls)
+			fprintf(f, "%s %llu\n", idName(id), (unsigned long long)netCycles(id));
+	}
+	fclose(f);
+	return 1;
+}
+
+/*!
+ ********************************************************************************
+ * compareBaseline
+ *
+ * \returns number of paths slower than baseline + tolerance, -1 on error
+ *          or baseline without any path (not recorded yet)
+ *******************************************************************************/
+static int compareBaseline(const char *file, int tolerance)
+{
+	FILE *f;
+	char line[128];
+	int regressions = 0;
+	int paths = 0;
+
+	f = fopen(file, "r");
+	if (f == NULL)
+	{
+		perror(file);
+		return -1;
+	}
+	printf("\n%-24s %10s %10s %8s\n", "path", "baseline", "now", "change");
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		char name[64];
+		unsigned long long base;
+		int id;
+
+		if ((line[0] == '#') || (sscanf(line, "%63s %llu", name, &base) != 2))
+			continue;
+		paths++;
+		for (id = 1; id < BENCH_END; id++)
+		{
+			if (results[id].calls && (strcmp(idName(id), name) == 0))
+				break;
+		}
+		if (id == BENCH_END)
+		{
+			printf("%-24s %10llu %10s\n", name, base, "missing");
+			regressions++;
+			continue;
+		}
+		{
+			uint64_t now = netCycles(id);
+			double change = base ? (100.0 * ((double)now - (double)base) / (double)base) : 0.0;
+			int bad = (now > base) && (change > tolerance);
+
+			printf("%-24s %10llu %10llu %+7.1f%%%s\n", name, base,
+			       (unsigned long long)now, change, bad ? " REGRESSION" : "");
+			if (bad)
+				regressions++;
+		}
+	}
+	fclose(f);
+	if (paths == 0)
+	{
+		fprintf(stderr, "%s: no baseline recorded, run make bench-baseline\n", file);
+		return -1;
+	}
+	return regressions;
+}
+
+int main(int argc, char **argv)
+{
+	const char *file = "hr20_bench.elf";
+	const char *mcu = "atmega169p";
+	const char *baseline = NULL;
+	const char *output = NULL;
+	uint32_t freq = 4000000;
+	int tolerance = TOLERANCE;
+	uint64_t limit = CYCLE_LIMIT;
+	elf_firmware_t fw;
+	avr_t *avr;
+	int state;
+	int id;
+	int c;
+	int option_index = 0;
+
+	while ((c = getopt_long(argc, argv, "f:m:F:b:o:t:c:h", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+		case 'f':
+			file = optarg;
+			break;
+		case 'm':
+			mcu = optarg;
+			break;
+		case 'F':
+			freq = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			baseline = optarg;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 't':
+			tolerance = atoi(optarg);
+			break;
+		case 'c':
+			limit = strtoull(optarg, NULL, 0);
+			break;
+		default:
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+	}
+
+	memset(&fw, 0, sizeof(fw));
+	if (elf_read_firmware(file, &fw) != 0)
+	{
+		fprintf(stderr, "%s: can't read firmware\n", file);
+		return EXIT_FAILURE;
+	}
+	if (fw.mmcu[0] == 0)
+		strncpy(fw.mmcu, mcu, sizeof(fw.mmcu) - 1);
+	if (fw.frequency == 0)
+		fw.frequency = freq;
+	avr = avr_make_mcu_by_name(fw.mmcu);
+	if (avr == NULL)
+	{
+		fprintf(stderr, "unknown mcu %s\n", fw.mmcu);
+		return EXIT_FAILURE;
+	}
+	avr_init(avr);
+	avr_load_firmware(avr, &fw);
+	avr_register_io_write(avr, BENCH_MARK_ADDR, markWrite, NULL);
+
+	do
+	{
+		state = avr_run(avr);
+	}
+	while (!finished && (state != cpu_Done) && (state != cpu_Crashed) && (avr->cycle < limit));
+
+	if (!finished)
+	{
+		fprintf(stderr, "benchmark not finished (state %d, %llu cycles)\n",
+		        state, (unsigned long long)avr->cycle);
+		return EXIT_FAILURE;
+	}
+
+	printf("%s %s %u Hz\n\n", file, fw.mmcu, fw.frequency);
+	printf("%-24s %6s %10s %10s %10s %10s %9s\n", "path", "calls", "min", "avg", "max", "net", "us");
+	for (id = 1; id < BENCH_END; id++)
+	{
+		struct result *r = &results[id];
+
+		if (r->calls == 0)
+			continue;
+		printf("%-24s %6u %10llu %10llu %10llu %10llu %9.1f\n", idName(id), r->calls,
+		       (unsigned long long)r->min, (unsigned long long)(r->sum / r->calls),
+		       (unsigned long long)r->max, (unsigned long long)netCycles(id),
+		       netCycles(id) * 1e6 / fw.frequency);
+	}
+
+	if ((output != NULL) && !writeResult(output, file, fw.frequency))
+		return EXIT_FAILURE;
+	if (baseline != NULL)
+	{
+		int n = compareBaseline(baseline, tolerance);
+		if (n != 0)
+		{
+			if (n > 0)
+				fprintf(stderr, "\n%d path(s) slower than baseline by more than %d%%\n", n, tolerance);
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,279 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20bin.c
+ * \brief	decoder for binary packet dump of the rfm-master
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "hr20bin.h"
+
+#define ST_TEXT 0
+#define ST_LEN 1
+#define ST_DATA 2
+
+#define calc_temp(t) (((uint16_t)(t)) * 50)     // same as rfm-master/com.c
+
+/*!
+ ********************************************************************************
+ * hr20binInit
+ *
+ * reset parser state, must be called before first hr20binFeed
+ *
+ * \param *p parser
+ *******************************************************************************/
+void hr20binInit(hr20bin_parser_t *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->state = ST_TEXT;
+}
+
+/*!
+ ********************************************************************************
+ * hr20binFeed
+ *
+ * push one byte from serial line to parser
+ *
+ * \param *p parser
+ * \param c received byte
+ * \returns HR20BIN_NONE, HR20BIN_LINE, HR20BIN_PACKET or HR20BIN_ERROR
+ *******************************************************************************/
+int hr20binFeed(hr20bin_parser_t *p, uint8_t c)
+{
+	if (c == HR20BIN_SYNC)
+	{
+		// sync is never escaped, it always starts new record
+		int broken = (p->state != ST_TEXT);
+		p->state = ST_LEN;
+		p->esc = 0;
+		p->sum = 0;
+		p->pos = 0;
+		p->line_len = 0;
+		return broken ? HR20BIN_ERROR : HR20BIN_NONE;
+	}
+	if (p->state == ST_TEXT)
+	{
+		if (c == '\r')
+			return HR20BIN_NONE;
+		if (c == '\n')
+		{
+			p->line[p->line_len] = '\0';
+			p->line_len = 0;
+			return HR20BIN_LINE;
+		}
+		if (p->line_len < HR20BIN_MAX_LINE - 1)
+			p->line[p->line_len++] = c;
+		return HR20BIN_NONE;
+	}
+	if (c == HR20BIN_ESC)
+	{
+		p->esc = 1;
+		return HR20BIN_NONE;
+	}
+	if (p->esc)
+	{
+		c ^= HR20BIN_XOR;
+		p->esc = 0;
+	}
+	if (p->state == ST_LEN)
+	{
+		if ((c < HR20BIN_HEADER) || (c > HR20BIN_HEADER + HR20BIN_MAX_PAYLOAD))
+		{
+			p->state = ST_TEXT;
+			return HR20BIN_ERROR;
+		}
+		p->need = c;
+		p->sum = c;
+		p->state = ST_DATA;
+		return HR20BIN_NONE;
+	}
+	// ST_DATA
+	if (p->pos < p->need)
+	{
+		p->buf[p->pos++] = c;
+		p->sum += c;
+		return HR20BIN_NONE;
+	}
+	// checksum byte
+	p->state = ST_TEXT;
+	if (c != p->sum)
+		return HR20BIN_ERROR;
+	p->pkt.addr = p->buf[0];
+	p->pkt.sec = p->buf[1];
+	p->pkt.s100 = p->buf[2];
+	p->pkt.seq = (p->buf[3] << 8) | p->buf[4];
+	p->pkt.afc = (int8_t)p->buf[5];
+	p->pkt.len = p->need - HR20BIN_HEADER;
+	memcpy(p->pkt.data, p->buf + HR20BIN_HEADER, p->pkt.len);
+	return HR20BIN_PACKET;
+}
+
+/*!
+ ********************************************************************************
+ * hr20binNextRecord
+ *
+ * decode next command record from packet payload
+ *
+ * \param *pkt packet from hr20binFeed
+ * \param *offset position in payload, start with 0
+ * \param *rec decoded record
+ * \returns 1 record decoded, 0 end of packet, -1 incomplete record
+ *******************************************************************************/
+int hr20binNextRecord(const hr20bin_packet_t *pkt, int *offset, hr20bin_record_t *rec)
+{
+	const uint8_t *d = pkt->data + *offset;
+	int len = pkt->len - *offset;
+	int size, i;
+
+	if (len <= 0)
+		return 0;
+	memset(rec, 0, sizeof(*rec));
+	rec->reply = (d[0] & PROTO_REPLY) != 0;
+	rec->cmd = d[0] & ~PROTO_REPLY;
+	size = proto_reply_size(d, len);
+	switch (proto_reply_format(d[0]))
+	{
+	case PROTO_FMT_TEXT:
+		for (i = 1; (i < len) && (d[i] != '\n'); i++)
+			rec->u.raw.data[rec->u.raw.len++] = d[i] & 0x7f;
+		break;
+	case PROTO_FMT_STATUS:
+		if (size > len)
+			break;
+		rec->u.status.min = d[PROTO_STATUS_MIN] & PROTO_STATUS_TIME_MASK;
+		rec->u.status.test_auto = (d[PROTO_STATUS_MIN] & PROTO_STATUS_TEST_AUTO) != 0;
+		rec->u.status.mode_auto = (d[PROTO_STATUS_MIN] & PROTO_STATUS_MODE_AUTO) != 0;
+		rec->u.status.sec = d[PROTO_STATUS_SEC] & PROTO_STATUS_TIME_MASK;
+		rec->u.status.window_open = (d[PROTO_STATUS_SEC] & PROTO_STATUS_WINDOW) != 0;
+		rec->u.status.locked = (d[PROTO_STATUS_SEC] & PROTO_STATUS_LOCKED) != 0;
+		rec->u.status.error = d[PROTO_STATUS_ERROR];
+		rec->u.status.temp_average = proto_word(d, PROTO_STATUS_TEMP);
+		rec->u.status.bat_average = proto_word(d, PROTO_STATUS_BAT);
+		rec->u.status.temp_wanted = calc_temp(d[PROTO_STATUS_WANTED]);
+		rec->u.status.valve = d[PROTO_STATUS_VALVE];
+		break;
+	case PROTO_FMT_WORD:
+		if (size > len)
+			break;
+		rec->u.word.idx = d[1];
+		rec->u.word.value = proto_word(d, 2);
+		break;
+	case PROTO_FMT_BYTE:
+		if (size > len)
+			break;
+		rec->u.byte.idx = d[1];
+		rec->u.byte.value = d[2];
+		break;
+	case PROTO_FMT_VALUE:
+		if (size > len)
+			break;
+		rec->u.value = d[1];
+		break;
+	case PROTO_FMT_TRACE:
+		if ((size > len) || (d[PROTO_TRACE_LEN] > 2 * HR20BIN_TRACE_MAX))
+		{
+			size = len + 1;
+			break;
+		}
+		rec->u.trace.seq = d[1];
+		rec->u.trace.len = d[PROTO_TRACE_LEN] / 2;
+		for (i = 0; i < rec->u.trace.len; i++)
+			rec->u.trace.value[i] = proto_word(d, PROTO_TRACE_LEN + 1 + 2 * i);
+		break;
+	default:
+		// 'P' index and profile, other commands
+		if (size > len)
+			break;
+		memcpy(rec->u.raw.data, d + 1, size - 1);
+		rec->u.raw.len = size - 1;
+		break;
+	}
+	if (size > len)
+	{
+		*offset = pkt->len;
+		return -1;
+	}
+	*offset += size;
+	return 1;
+}
+
+/*!
+ ********************************************************************************
+ * hr20binFormatRecord
+ *
+ * format record same way as text dump of rfm-master, existing line parsers
+ * (frontend/tools/daemon.php) can be used without change
+ *
+ * \param *rec record
+ * \param *out output buffer
+ * \param size size of output buffer
+ * \returns length of string (snprintf semantic)
+ *******************************************************************************/
+int hr20binFormatRecord(const hr20bin_record_t *rec, char *out, int size)
+{
+	char mark = rec->reply ? '*' : '-';
+	int n = 0;
+	int i;
+
+	switch (proto_reply_format(rec->cmd))
+	{
+	case PROTO_FMT_TEXT:
+		return snprintf(out, size, "%c%c%.*s", mark, rec->cmd, rec->u.raw.len, rec->u.raw.data);
+	case PROTO_FMT_STATUS:
+		return snprintf(out, size, "%c%c m%02u s%02u %c V%02u I%02u%02u S%02u%02u B%02u%02u E%02x%s%s",
+				mark, rec->cmd,
+				rec->u.status.min, rec->u.status.sec,
+				rec->u.status.mode_auto ? (rec->u.status.test_auto ? 'A' : '-') : 'M',
+				rec->u.status.valve,
+				rec->u.status.temp_average / 100, rec->u.status.temp_average % 100,
+				rec->u.status.temp_wanted / 100, rec->u.status.temp_wanted % 100,
+				rec->u.status.bat_average / 100, rec->u.status.bat_average % 100,
+				rec->u.status.error,
+				rec->u.status.window_open ? " W" : "",
+				rec->u.status.locked ? " L" : "");
+	case PROTO_FMT_WORD:
+		return snprintf(out, size, "%c%c[%02x]=%04x", mark, rec->cmd, rec->u.word.idx, rec->u.word.value);
+	case PROTO_FMT_BYTE:
+		return snprintf(out, size, "%c%c[%02x]=%02x", mark, rec->cmd, rec->u.byte.idx, rec->u.byte.value);
+	case PROTO_FMT_VALUE:
+		return snprintf(out, size, "%c%c%02x", mark, rec->cmd, rec->u.value);
+	case PROTO_FMT_PROFILE:
+		n = snprintf(out, size, "%c%c[%02x]=", mark, rec->cmd, (uint8_t)rec->u.raw.data[0]);
+		for (i = 1; (i < rec->u.raw.len) && (n < size); i++)
+			n += snprintf(out + n, size - n, "%02x", (uint8_t)rec->u.raw.data[i]);
+		return n;
+	case PROTO_FMT_TRACE:
+		n = snprintf(out, size, "%c%c[%02x]=", mark, rec->cmd, rec->u.trace.seq);
+		for (i = 0; (i < rec->u.trace.len) && (n < size); i++)
+			n += snprintf(out + n, size - n, "%04x", rec->u.trace.value[i]);
+		return n;
+	default:
+		// master prints unknown command without command char, only hex dump
+		n = snprintf(out, size, "%c %02x", mark, (uint8_t)rec->cmd);
+		for (i = 0; (i < rec->u.raw.len) && (n < size); i++)
+			n += snprintf(out + n, size - n, " %02x", (uint8_t)rec->u.raw.data[i]);
+		return n;
+	}
+}
@@ -0,0 +1,133 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20bin.h
+ * \brief	decoder for binary packet dump of the rfm-master ("X01" command)
+ *
+ * Stream from master is mix of text lines and binary records:
+ * <tt>SYNC len addr sec s100 seqH seqL afc payload[len-6] sum</tt>
+ * Bytes 0x00, SYNC and ESC are sent as ESC (byte^0x20), see rfm-master/com.c
+ */
+
+#ifndef __HR20BIN_H__
+#define __HR20BIN_H__
+
+#include <stdint.h>
+
+#include "protocol.h"
+
+#define HR20BIN_SYNC 0xa5       //!< must match COM_BIN_SYNC in rfm-master/com.h
+#define HR20BIN_ESC 0xdb        //!< must match COM_BIN_ESC
+#define HR20BIN_XOR 0x20        //!< must match COM_BIN_XOR
+#define HR20BIN_HEADER 6        //!< must match COM_BIN_HEADER
+
+#define HR20BIN_MAX_PAYLOAD 128
+#define HR20BIN_MAX_LINE 256
+#define HR20BIN_TRACE_MAX PROTO_TRACE_MAX
+
+/*! result of hr20binFeed */
+enum
+{
+	HR20BIN_NONE = 0,       //!< need more data
+	HR20BIN_LINE,           //!< text line is in parser->line
+	HR20BIN_PACKET,         //!< binary record is in parser->pkt
+	HR20BIN_ERROR           //!< broken record (checksum, length), dropped
+};
+
+/*! one authenticated radio packet */
+typedef struct
+{
+	uint8_t addr;           //!< slave address
+	uint8_t sec;            //!< master RTC second at reception
+	uint8_t s100;           //!< master RTC 1/100 second at reception
+	uint16_t seq;           //!< master packet sequence number (same as PKTxxxx)
+	int8_t afc;             //!< AFC value, 0 on masters without RFM_TUNING
+	uint8_t len;            //!< payload length
+	uint8_t data[HR20BIN_MAX_PAYLOAD];
+} hr20bin_packet_t;
+
+/*! stream parser state */
+typedef struct
+{
+	int state;
+	int esc;
+	int need;
+	int pos;
+	uint8_t sum;
+	uint8_t buf[HR20BIN_MAX_PAYLOAD + HR20BIN_HEADER];
+	int line_len;
+	char line[HR20BIN_MAX_LINE];    //!< last text line, without '\n'
+	hr20bin_packet_t pkt;           //!< last binary record
+} hr20bin_parser_t;
+
+/*! one command record inside of packet payload */
+typedef struct
+{
+	char cmd;               //!< 'D','A','M','T','R','W','Z','G','S','K','L','U','F','P','J','V' or other
+	int reply;              //!< 1 = reply from thermostat ('*' in text dump), 0 = '-'
+	union
+	{
+		struct                  //!< 'D', 'A', 'M'
+		{
+			uint8_t min;
+			uint8_t sec;
+			int mode_auto;
+			int test_auto;
+			int window_open;
+			int locked;
+			uint8_t error;
+			uint16_t temp_average;  //!< 1/100 C
+			uint16_t bat_average;   //!< mV
+			uint16_t temp_wanted;   //!< 1/100 C
+			uint8_t valve;          //!< %
+		} status;
+		struct                  //!< 'T', 'R', 'W', 'Z' (interval, mask)
+		{
+			uint8_t idx;
+			uint16_t value;
+		} word;
+		struct                  //!< 'G', 'S', 'K'
+		{
+			uint8_t idx;
+			uint8_t value;
+		} byte;
+		uint8_t value;          //!< 'L', 'U', 'F'
+		struct                  //!< 'J' records of watch trace from seq
+		{
+			uint8_t seq;
+			uint8_t len;    //!< words
+			uint16_t value[HR20BIN_TRACE_MAX];
+		} trace;
+		struct                  //!< 'V' text, 'P' index and profile, other commands raw data
+		{
+			uint8_t len;
+			char data[HR20BIN_MAX_PAYLOAD];
+		} raw;
+	} u;
+} hr20bin_record_t;
+
+extern void hr20binInit(hr20bin_parser_t *p);
+extern int hr20binFeed(hr20bin_parser_t *p, uint8_t c);
+extern int hr20binNextRecord(const hr20bin_packet_t *pkt, int *offset, hr20bin_record_t *rec);
+extern int hr20binFormatRecord(const hr20bin_record_t *rec, char *out, int size);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20bindump.c
+ * \brief	convert binary master stream back to text dump, example of hr20bin usage
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "hr20bin.h"
+
+/*!
+ ********************************************************************************
+ * printPacket
+ *
+ * print packet in same format as rfm-master text mode
+ *
+ * \param *pkt packet
+ *******************************************************************************/
+static void printPacket(const hr20bin_packet_t *pkt)
+{
+	hr20bin_record_t rec;
+	char line[HR20BIN_MAX_LINE];
+	int offset = 0;
+	int ret;
+
+	printf("@%02u.%02u PKT%04x AFC%02x\n", pkt->sec, pkt->s100, pkt->seq, (uint8_t)pkt->afc);
+	if (pkt->len == 0)
+		return;
+	printf("(%02x){\n", pkt->addr);
+	while ((ret = hr20binNextRecord(pkt, &offset, &rec)) != 0)
+	{
+		hr20binFormatRecord(&rec, line, sizeof(line));
+		if (ret < 0)
+			printf("%s!!\n", line);
+		else
+			printf("%s\n", line);
+	}
+	printf("}\n");
+}
+
+int main(int argc, char **argv)
+{
+	hr20bin_parser_t parser;
+	FILE *fp = stdin;
+	int c;
+
+	if (argc > 1)
+	{
+		fp = fopen(argv[1], "rb");
+		if (fp == NULL)
+		{
+			perror(argv[1]);
+			return EXIT_FAILURE;
+		}
+	}
+	hr20binInit(&parser);
+	while ((c = fgetc(fp)) != EOF)
+	{
+		switch (hr20binFeed(&parser, (uint8_t)c))
+		{
+		case HR20BIN_LINE:
+			printf("%s\n", parser.line);
+			break;
+		case HR20BIN_PACKET:
+			printPacket(&parser.pkt);
+			break;
+		case HR20BIN_ERROR:
+			fprintf(stderr, "broken binary record\n");
+			break;
+		default:
+			break;
+		}
+		fflush(stdout);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,36 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	pgmspace.h
+ * \brief	host has one address space, flash data is ordinary memory
+ */
+
+#ifndef __PGMSPACE_H__
+#define __PGMSPACE_H__
+
+#include <string.h>
+
+#define PROGMEM
+#define memcpy_P memcpy
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20cryptotest.c
+ * \brief	cross-check and benchmark of host XTEA/CMAC (common/xtea.c, common/cmac.c)
+ *
+ * Vectors are results of firmware code: xtea-asm.S run instruction by
+ * instruction, key setup and CMAC as in cmac_init() and cmac_calc().
+ * Host library must give the same bytes, otherwise gateway can't check
+ * frames of thermostats.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/time.h>
+
+#include "config.h"
+#include "xtea.h"
+#include "wireless.h"
+#include "cmac.h"
+
+#define HR20CRYPTOTEST_VERSION "0.1"
+
+#define BENCH_FRAME 20          //!< typical payload of wireless frame
+#define BENCH_STREAM 4096       //!< keystream buffer
+
+uint8_t Keys[5 * 8];            //!< wireless.c is not part of host build
+
+struct xtea_vector
+{
+	uint8_t key[16];
+	uint8_t plain[8];
+	uint8_t cipher[8];
+};
+
+struct key_vector
+{
+	uint8_t security_key[8];
+	uint8_t keys[5 * 8];    //!< K_mac, K_enc, K1, K2 as in Keys[]
+};
+
+struct cmac_vector
+{
+	uint8_t bytes;
+	uint8_t prefix;
+	uint8_t mac[4];
+};
+
+static const struct xtea_vector xtea_vectors[] =
+{
+	{ { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	  { 0xd8, 0xd4, 0xe9, 0xde, 0xd9, 0x1e, 0x13, 0xf7 } },
+	{ { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+	  { 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48 },
+	  { 0xca, 0xe7, 0x69, 0x7e, 0x00, 0x6e, 0xe9, 0x21 } },
+	{ { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c },
+	  { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96 },
+	  { 0xc4, 0x6b, 0xe2, 0xf0, 0xa9, 0x54, 0x83, 0xd8 } },
+	{ { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	  { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	  { 0x91, 0x28, 0xfc, 0x28, 0x6a, 0x56, 0x23, 0xe6 } },
+};
+
+static const struct key_vector key_vectors[] =
+{
+	{ { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	  {
+		0xc6, 0x0e, 0xa7, 0x0d, 0xee, 0x9c, 0x40, 0x6b,
+		0x6b, 0x90, 0x01, 0xa1, 0xf1, 0x69, 0x9a, 0x16,
+		0x4a, 0xfa, 0x87, 0x7a, 0x38, 0x59, 0x52, 0x2d,
+		0xcb, 0x33, 0xe2, 0x1f, 0xde, 0xbc, 0xc3, 0x45,
+		0x96, 0x67, 0xc4, 0x3f, 0xbc, 0x79, 0x87, 0x8b
+	  } },
+	{ { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef },
+	  {
+		0x3b, 0xd6, 0xf1, 0xa6, 0xac, 0x20, 0xb2, 0xb4,
+		0x0e, 0x59, 0x80, 0x93, 0x8a, 0xba, 0xb5, 0x88,
+		0x30, 0xa4, 0xf9, 0xc7, 0x2f, 0xd6, 0xff, 0xd6,
+		0x5e, 0x06, 0xd8, 0x8e, 0x3d, 0x1a, 0x68, 0x3e,
+		0xbc, 0x0c, 0xb0, 0x1d, 0x7b, 0x34, 0xd0, 0x7c
+	  } },
+};
+
+static const struct cmac_vector cmac_vectors[] =
+{
+	{  5, 0, { 0x20, 0x8c, 0x0b, 0x8f } },
+	{  5, 1, { 0x2a, 0x3a, 0x25, 0x3a } },
+	{  8, 0, { 0xbe, 0xc7, 0x97, 0xe0 } },
+	{  8, 1, { 0x6b, 0x04, 0xda, 0x5f } },
+	{ 13, 0, { 0x37, 0xe2, 0xf3, 0x38 } },
+	{ 13, 1, { 0x8b, 0xc5, 0x7f, 0x50 } },
+	{ 16, 0, { 0x38, 0xf7, 0xdc, 0x61 } },
+	{ 16, 1, { 0xc5, 0x3f, 0xc9, 0xb3 } },
+	{ 27, 0, { 0x56, 0x97, 0x06, 0x20 } },
+	{ 27, 1, { 0xa8, 0x9a, 0x9e, 0xcf } },
+};
+
+
+static const uint8_t cmac_prefix[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+static void printHex(const char *name, const uint8_t *d, int len)
+{
+	int i;
+
+	printf("  %s", name);
+	for (i = 0; i < len; i++)
+		printf(" %02x", d[i]);
+	printf("\n");
+}
+
+/*!
+ ********************************************************************************
+ * checkXtea
+ *
+ * \returns number of errors
+ *******************************************************************************/
+static int checkXtea(void)
+{
+	int errors = 0;
+	size_t i;
+
+	for (i = 0; i < sizeof(xtea_vectors) / sizeof(xtea_vectors[0]); i++)
+	{
+		const struct xtea_vector *x = &xtea_vectors[i];
+		uint8_t buf[8];
+
+		xtea_enc(buf, x->plain, x->key);
+		if (memcmp(buf, x->cipher, 8) != 0)
+		{
+			printf("xtea_enc vector %d failed\n", (int)i);
+			printHex("expected", x->cipher, 8);
+			printHex("got     ", buf, 8);
+			errors++;
+		}
+		xtea_dec(buf, x->cipher, x->key);
+		if (memcmp(buf, x->plain, 8) != 0)
+		{
+			printf("xtea_dec vector %d failed\n", (int)i);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+/*!
+ ********************************************************************************
+ * checkKeys
+ *
+ * \returns number of errors
+ *******************************************************************************/
+static int checkKeys(void)
+{
+	int errors = 0;
+	size_t i;
+
+	for (i = 0; i < sizeof(key_vectors) / sizeof(key_vectors[0]); i++)
+	{
+		cmac_init(key_vectors[i].security_key);
+		if (memcmp(Keys, key_vectors[i].keys, sizeof(Keys)) != 0)
+		{
+			printf("cmac_init vector %d failed\n", (int)i);
+			printHex("expected", key_vectors[i].keys, sizeof(Keys));
+			printHex("got     ", Keys, sizeof(Keys));
+			errors++;
+		}
+	}
+	return errors;
+}
+
+/*!
+ ********************************************************************************
+ * checkCmac
+ *
+ * MAC of vectors, check of own MAC and of modified message
+ *
+ * \returns number of errors
+ *******************************************************************************/
+static int checkCmac(void)
+{
+	int errors = 0;
+	size_t i;
+
+	cmac_init(key_vectors[1].security_key);
+	for (i = 0; i < sizeof(cmac_vectors) / sizeof(cmac_vectors[0]); i++)
+	{
+		const struct cmac_vector *c = &cmac_vectors[i];
+		uint8_t *prefix = c->prefix ? (uint8_t *)cmac_prefix : NULL;
+		uint8_t m[32 + 4];
+		int j;
+
+		for (j = 0; j < c->bytes; j++)
+			m[j] = j * 7 + 3;
+		cmac_calc(m, c->bytes, prefix, false);
+		if (memcmp(m + c->bytes, c->mac, 4) != 0)
+		{
+			printf("cmac_calc vector %d failed\n", (int)i);
+			printHex("expected", c->mac, 4);
+			printHex("got     ", m + c->bytes, 4);
+			errors++;
+		}
+		if (!cmac_calc(m, c->bytes, prefix, true))
+		{
+			printf("cmac_calc check %d failed\n", (int)i);
+			errors++;
+		}
+		m[0] ^= 0x01;
+		if (cmac_calc(m, c->bytes, prefix, true))
+		{
+			printf("cmac_calc accepts modified message %d\n", (int)i);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+static double elapsed(const struct timeval *start)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec - start->tv_sec) + (tv.tv_usec - start->tv_usec) / 1e6;
+}
+
+/*!
+ ********************************************************************************
+ * bench
+ *
+ * XTEA blocks, CMAC of frames and keystream (same as encrypt_decrypt() in
+ * wireless.c: counter block encrypted by K_enc, XOR with data)
+ *******************************************************************************/
+static void bench(double seconds)
+{
+	static uint8_t stream[BENCH_STREAM];
+	uint8_t blk[8] = { 0 };
+	uint8_t m[BENCH_FRAME + 4];
+	struct timeval start;
+	unsigned long n;
+	double t;
+
+	cmac_init(key_vectors[1].security_key);
+
+	gettimeofday(&start, NULL);
+	for (n = 0; (t = elapsed(&start)) < seconds; n += 1000)
+	{
+		int i;
+		for (i = 0; i < 1000; i++)
+			xtea_enc(blk, blk, K_enc);
+	}
+	printf("xtea_enc   %10.0f blocks/s %8.2f MB/s\n", n / t, n * 8 / t / 1e6);
+
+	memset(m, 0x55, sizeof(m));
+	gettimeofday(&start, NULL);
+	for (n = 0; (t = elapsed(&start)) < seconds; n += 1000)
+	{
+		int i;
+		for (i = 0; i < 1000; i++)
+			cmac_calc(m, BENCH_FRAME, NULL, false);
+	}
+	printf("cmac_calc  %10.0f frames/s (%d bytes)\n", n / t, BENCH_FRAME);
+
+	gettimeofday(&start, NULL);
+	for (n = 0; (t = elapsed(&start)) < seconds; n++)
+	{
+		int i;
+		for (i = 0; i < BENCH_STREAM; i++)
+		{
+			if ((i & 7) == 0)
+			{
+				xtea_enc(m, blk, K_enc);
+				blk[7]++;       // pkt_cnt
+			}
+			stream[i] ^= m[i & 7];
+		}
+	}
+	printf("keystream  %10.2f MB/s\n", n * (double)BENCH_STREAM / t / 1e6);
+}
+
+static struct option long_options[] =
+{
+	{"bench", required_argument, 0, 'b'},
+	{"check", no_argument, 0, 'c'},
+	{"help", no_argument, 0, 'h'},
+	{0, 0, 0, 0}
+};
+
+static void printUsage(void)
+{
+	printf("hr20cryptotest version %s\n", HR20CRYPTOTEST_VERSION);
+	printf("\nOptions:\n\n");
+	printf("--bench       -b\tseconds for every benchmark (default 1)\n");
+	printf("--check       -c\tcross-check only, no benchmark\n");
+	printf("--help        -h\tthis help\n");
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = 1.0;
+	int check_only = 0;
+	int errors;
+	int c;
+	int option_index = 0;
+
+	while ((c = getopt_long(argc, argv, "b:ch", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+		case 'b':
+			seconds = atof(optarg);
+			break;
+		case 'c':
+			check_only = 1;
+			break;
+		default:
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+	}
+
+	errors = checkXtea() + checkKeys() + checkCmac();
+	printf("cross-check: %s\n", errors ? "FAILED" : "ok");
+	if (errors)
+		return EXIT_FAILURE;
+	if (!check_only)
+		bench(seconds);
+	return EXIT_SUCCESS;
+}
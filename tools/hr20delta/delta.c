@@ -0,0 +1,343 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	delta.c
+ * \brief	in-place delta of two firmware images
+ *
+ * Bootloader overwrites flash page by page, so copy source is always current
+ * flash content: old image for pages not written yet, new image for written
+ * pages. Encoder simulates flash the same way. Pages are written in
+ * ascending or descending order, the shorter result is used.
+ */
+
+#include <string.h>
+
+#include "delta.h"
+
+#define MIN_COPY 4              //!< copy op has 3 bytes
+
+/*!
+ ********************************************************************************
+ * deltaCrc
+ *
+ * CRC16 of image, same as _crc_xmodem_update of avr-libc
+ *******************************************************************************/
+uint16_t deltaCrc(const uint8_t *d, int len)
+{
+	uint16_t c = 0;
+	int i, j;
+
+	for (i = 0; i < len; i++)
+	{
+		c ^= (uint16_t)d[i] << 8;
+		for (j = 0; j < 8; j++)
+			c = (c & 0x8000) ? ((c << 1) ^ 0x1021) : (c << 1);
+	}
+	return c;
+}
+
+/*!
+ ********************************************************************************
+ * decodeChunk
+ *
+ * build one page from chunk, same as ota_patch in bootloader
+ *
+ * \param *page output, OTA_PAGE bytes
+ * \param *phys page byte of chunk (with OTA_DELTA_LAST)
+ * \returns bytes of chunk without padding, -1 on broken chunk
+ *******************************************************************************/
+static int decodeChunk(const uint8_t *c, int len, const uint8_t *flash, uint8_t *page, int *phys)
+{
+	int pos = 0;
+	int i = 1;
+
+	if (len < 1)
+		return -1;
+	*phys = c[0];
+	while (pos < OTA_PAGE)
+	{
+		int n;
+		if (i >= len)
+			return -1;
+		n = (c[i] & ~OTA_DELTA_COPY) + 1;
+		if (c[i++] & OTA_DELTA_COPY)
+		{
+			int addr;
+			if (i + 2 > len)
+				return -1;
+			addr = (c[i] << 8) | c[i + 1];
+			i += 2;
+			while ((n-- > 0) && (pos < OTA_PAGE))
+			{
+				if (addr >= DELTA_FLASH)
+					return -1;
+				page[pos++] = flash[addr++];
+			}
+		}
+		else
+		{
+			while ((n-- > 0) && (pos < OTA_PAGE))
+			{
+				if (i >= len)
+					return -1;
+				page[pos++] = c[i++];
+			}
+		}
+	}
+	return i;
+}
+
+static int padBlock(int n)
+{
+	return (n + OTA_BLOCK - 1) / OTA_BLOCK * OTA_BLOCK;
+}
+
+/*!
+ ********************************************************************************
+ * encodePage
+ *
+ * greedy longest match against valid flash pages
+ *
+ * \returns length of chunk without padding
+ *******************************************************************************/
+static int encodePage(const uint8_t *flash, const int *valid, const uint8_t *t, int phys, uint8_t *out)
+{
+	int n = 0;
+	int lit = -1;           // position of literal op in out
+	int i = 0;
+
+	out[n++] = phys;
+	while (i < OTA_PAGE)
+	{
+		int best = 0;
+		int best_addr = 0;
+		int a;
+
+		for (a = 0; a < DELTA_FLASH; a++)
+		{
+			int l = 0;
+			if (!valid[a / OTA_PAGE])
+			{
+				a += OTA_PAGE - 1 - a % OTA_PAGE;
+				continue;
+			}
+			while ((i + l < OTA_PAGE) && (a + l < DELTA_FLASH) && valid[(a + l) / OTA_PAGE]
+			       && (flash[a + l] == t[i + l]))
+				l++;
+			if (l > best)
+			{
+				best = l;
+				best_addr = a;
+				if (i + l == OTA_PAGE)
+					break;
+			}
+		}
+		if (best >= MIN_COPY)
+		{
+			out[n++] = OTA_DELTA_COPY | (best - 1);
+			out[n++] = best_addr >> 8;
+			out[n++] = best_addr & 0xff;
+			i += best;
+			lit = -1;
+		}
+		else
+		{
+			if ((lit < 0) || (out[lit] == 0x7f))
+			{
+				lit = n;
+				out[n++] = 0xff;        // incremented to 0 below
+			}
+			out[lit]++;
+			out[n++] = t[i++];
+		}
+	}
+	return n;
+}
+
+/*!
+ ********************************************************************************
+ * encode
+ *
+ * create chunks for one page order
+ *
+ * \returns patch length, 0 if images are same
+ *******************************************************************************/
+static int encode(const uint8_t *old_img, int old_pages, const uint8_t *new_img, int new_pages, int descending, uint8_t *out)
+{
+	static uint8_t flash[DELTA_FLASH];
+	int valid[OTA_PAGES_MAX];
+	int n = DELTA_HEADER;
+	int last = -1;
+	int k;
+
+	memcpy(flash, old_img, DELTA_FLASH);
+	for (k = 0; k < OTA_PAGES_MAX; k++)
+		valid[k] = (k < old_pages);
+
+	// chunk 0, check of old image
+	memset(out + n, 0, OTA_BLOCK);
+	out[n] = old_pages;
+	out[n + 1] = deltaCrc(old_img, old_pages * OTA_PAGE) >> 8;
+	out[n + 2] = deltaCrc(old_img, old_pages * OTA_PAGE) & 0xff;
+	n += OTA_BLOCK;
+
+	for (k = 0; k < new_pages; k++)
+	{
+		int p = descending ? (new_pages - 1 - k) : k;
+		const uint8_t *t = new_img + p * OTA_PAGE;
+		int len;
+
+		if (valid[p] && (memcmp(flash + p * OTA_PAGE, t, OTA_PAGE) == 0))
+			continue;
+		len = encodePage(flash, valid, t, p, out + n);
+		memset(out + n + len, 0, padBlock(len) - len);
+		last = n;
+		n += padBlock(len);
+		memcpy(flash + p * OTA_PAGE, t, OTA_PAGE);
+		valid[p] = 1;
+	}
+	if (last < 0)
+		return 0;
+	out[last] |= OTA_DELTA_LAST;
+	return n;
+}
+
+/*!
+ ********************************************************************************
+ * deltaCreate
+ *
+ * create patch from old to new image
+ *
+ * \param *out patch buffer, DELTA_MAX bytes is enough
+ * \returns patch length, 0 if images are same, -1 on error
+ *******************************************************************************/
+int deltaCreate(const uint8_t *old_img, int old_len, const uint8_t *new_img, int new_len, uint8_t *out, int size)
+{
+	static uint8_t o[DELTA_FLASH], t[DELTA_FLASH];
+	static uint8_t desc_out[DELTA_MAX];
+	int old_pages = (old_len + OTA_PAGE - 1) / OTA_PAGE;
+	int new_pages = (new_len + OTA_PAGE - 1) / OTA_PAGE;
+	uint16_t crc;
+	int n, m;
+
+	if ((old_len <= 0) || (new_len <= 0) || (old_pages > OTA_PAGES_MAX) || (new_pages > OTA_PAGES_MAX)
+	    || (size < DELTA_MAX))
+		return -1;
+	memset(o, 0xff, sizeof(o));
+	memset(t, 0xff, sizeof(t));
+	memcpy(o, old_img, old_len);
+	memcpy(t, new_img, new_len);
+
+	n = encode(o, old_pages, t, new_pages, 0, out);
+	m = encode(o, old_pages, t, new_pages, 1, desc_out);
+	if (n == 0)
+		return 0;
+	if (m < n)
+	{
+		memcpy(out, desc_out, m);
+		n = m;
+	}
+	crc = deltaCrc(t, new_pages * OTA_PAGE);
+	out[0] = new_pages | OTA_DELTA;
+	out[1] = crc >> 8;
+	out[2] = crc & 0xff;
+	return n;
+}
+
+/*!
+ ********************************************************************************
+ * deltaChunks
+ *
+ * find chunks in patch, chunk k is sent as page k
+ *
+ * \param *start offsets of chunks, one more item is end of patch (max + 1 items)
+ * \returns number of chunks, -1 on broken patch, -2 more than max chunks
+ *******************************************************************************/
+int deltaChunks(const uint8_t *patch, int len, int *start, int max)
+{
+	static uint8_t flash[DELTA_FLASH];
+	uint8_t page[OTA_PAGE];
+	int n = DELTA_HEADER;
+	int k = 0;
+	int phys = 0;
+
+	if ((len < DELTA_HEADER + OTA_BLOCK) || !(patch[0] & OTA_DELTA))
+		return -1;
+	while (n < len)
+	{
+		int l = OTA_BLOCK;
+		if (k >= max)
+			return -2;
+		start[k++] = n;
+		if (k > 1)
+		{
+			l = decodeChunk(patch + n, len - n, flash, page, &phys);
+			if (l < 0)
+				return -1;
+		}
+		n += padBlock(l);
+		if (phys & OTA_DELTA_LAST)
+			break;
+	}
+	if (!(phys & OTA_DELTA_LAST))
+		return -1;
+	start[k] = n;
+	return k;
+}
+
+/*!
+ ********************************************************************************
+ * deltaApply
+ *
+ * apply patch in place, same steps as bootloader
+ *
+ * \param *flash DELTA_FLASH bytes, old image
+ * \returns pages of new image, -1 broken patch, -2 old image does not match,
+ *          -3 new image CRC does not match, -4 patch larger than chunk buffer
+ *******************************************************************************/
+int deltaApply(uint8_t *flash, const uint8_t *patch, int len)
+{
+	int start[OTA_PAGES_MAX + 2];
+	uint8_t page[OTA_PAGE];
+	const uint8_t *h;
+	int chunks, k, phys;
+	int new_pages = patch[0] & ~OTA_DELTA;
+
+	chunks = deltaChunks(patch, len, start, OTA_PAGES_MAX + 1);
+	if (chunks < 0)
+		return (chunks == -2) ? -4 : -1;
+	h = patch + start[0];
+	if (deltaCrc(flash, h[0] * OTA_PAGE) != ((h[1] << 8) | h[2]))
+		return -2;
+	for (k = 1; k < chunks; k++)
+	{
+		if (decodeChunk(patch + start[k], start[k + 1] - start[k], flash, page, &phys) < 0)
+			return -1;
+		phys &= ~OTA_DELTA_LAST;
+		if (phys >= OTA_PAGES_MAX)
+			return -1;
+		memcpy(flash + phys * OTA_PAGE, page, OTA_PAGE);
+	}
+	if (deltaCrc(flash, new_pages * OTA_PAGE) != ((patch[1] << 8) | patch[2]))
+		return -3;
+	return new_pages;
+}
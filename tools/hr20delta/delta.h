@@ -0,0 +1,46 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	delta.h
+ * \brief	in-place delta of two firmware images, format see common/ota.h
+ *
+ * Patch file: new_pages|OTA_DELTA new_crc_h new_crc_l (parameters of
+ * command F) followed by chunks, every chunk is padded to OTA_BLOCK.
+ */
+
+#ifndef __DELTA_H__
+#define __DELTA_H__
+
+#include <stdint.h>
+
+#include "ota.h"
+
+#define DELTA_HEADER 3                  //!< bytes before first chunk
+#define DELTA_FLASH (OTA_PAGES_MAX * OTA_PAGE)
+#define DELTA_MAX (DELTA_HEADER + OTA_BLOCK + OTA_PAGES_MAX * 10 * OTA_BLOCK)
+
+extern uint16_t deltaCrc(const uint8_t *d, int len);
+extern int deltaCreate(const uint8_t *old_img, int old_len, const uint8_t *new_img, int new_len, uint8_t *out, int size);
+extern int deltaChunks(const uint8_t *patch, int len, int *start, int max);
+extern int deltaApply(uint8_t *flash, const uint8_t *patch, int len);
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20delta.c
+ * \brief	create and check delta of two firmware images
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "delta.h"
+
+static int readImage(const char *file, uint8_t *buf)
+{
+	FILE *f;
+	int n;
+
+	f = fopen(file, "rb");
+	if (f == NULL)
+	{
+		perror(file);
+		return -1;
+	}
+	n = fread(buf, 1, DELTA_FLASH, f);
+	if ((n <= 0) || (fgetc(f) != EOF))
+	{
+		fprintf(stderr, "%s: image must have 1 .. %d bytes\n", file, DELTA_FLASH);
+		n = -1;
+	}
+	fclose(f);
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t old_img[DELTA_FLASH], new_img[DELTA_FLASH], flash[DELTA_FLASH];
+	static uint8_t patch[DELTA_MAX];
+	int start[OTA_PAGES_MAX + 2];
+	int old_len, new_len, len, chunks, frames, ret;
+	FILE *f;
+
+	if ((argc < 3) || (argc > 4))
+	{
+		printf("usage: hr20delta old.bin new.bin [patch.bin]\n");
+		return EXIT_FAILURE;
+	}
+	old_len = readImage(argv[1], old_img);
+	new_len = readImage(argv[2], new_img);
+	if ((old_len < 0) || (new_len < 0))
+		return EXIT_FAILURE;
+
+	len = deltaCreate(old_img, old_len, new_img, new_len, patch, sizeof(patch));
+	if (len <= 0)
+	{
+		fprintf(stderr, len ? "can't create patch\n" : "images are same\n");
+		return EXIT_FAILURE;
+	}
+
+	// check patch on copy of old image, the same way as bootloader
+	memset(flash, 0xff, sizeof(flash));
+	memcpy(flash, old_img, old_len);
+	ret = deltaApply(flash, patch, len);
+	if (ret == -4)
+	{
+		fprintf(stderr, "patch larger than buffer\n");
+		return EXIT_FAILURE;
+	}
+	if ((ret < 0) || (memcmp(flash, new_img, new_len) != 0))
+	{
+		fprintf(stderr, "patch check failed (%d)\n", ret);
+		return EXIT_FAILURE;
+	}
+
+	chunks = deltaChunks(patch, len, start, OTA_PAGES_MAX + 1);
+	frames = (len - DELTA_HEADER) / OTA_BLOCK;
+	printf("old %d bytes, new %d bytes (%d pages)\n", old_len, new_len, ret);
+	printf("patch %d bytes, %d changed pages, %d frames (full image %d frames)\n",
+	       len, chunks - 1, frames, ret * OTA_BLOCKS_PER_PAGE);
+
+	if (argc == 4)
+	{
+		f = fopen(argv[3], "wb");
+		if ((f == NULL) || (fwrite(patch, 1, len, f) != (size_t)len))
+		{
+			perror(argv[3]);
+			return EXIT_FAILURE;
+		}
+		fclose(f);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,424 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20flash.c
+ * \brief	serial firmware update of thermostat, streaming protocol of bootloader
+ *
+ * Pages are sent without waiting for answers (window), bootloader writes
+ * one page while it receives next one. Only pages with other CRC than
+ * flash content are sent, interrupted update continues on next start.
+ * Commands see STREAM_* in playground/Bootloader_JSachs/source/bootldr.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/select.h>
+
+#include "delta.h"
+
+#define HR20FLASH_VERSION "0.1"
+
+#define KEY 'd'                 //!< password of bootloader (bootcfg.h)
+#define PAGE OTA_PAGE
+#define FRAME (1 + 1 + PAGE + 2)        //!< 'P' page data crc16
+
+#define TIMEOUT_CONNECT 30000   //!< ms, time to reset thermostat
+#define TIMEOUT_ANSWER 2000     //!< ms
+#define SILENCE 400             //!< ms, bootloader drops data until 200ms silence
+#define MAX_ERRORS 10
+#define MAX_ROUNDS 3
+#define WINDOW 4
+
+static int fd = -1;
+static int verbose = 0;
+
+static uint8_t image[DELTA_FLASH];
+static int pages = 0;
+static uint16_t flash_crc[OTA_PAGES_MAX];
+
+static struct option long_options[] =
+{
+	{"port", required_argument, 0, 'p'},
+	{"file", required_argument, 0, 'f'},
+	{"window", required_argument, 0, 'w'},
+	{"reboot", no_argument, 0, 'b'},
+	{"verbose", no_argument, 0, 'v'},
+	{"help", no_argument, 0, 'h'},
+	{0, 0, 0, 0}
+};
+
+static void printUsage(void)
+{
+	printf("hr20flash version %s\n", HR20FLASH_VERSION);
+	printf("\nOptions:\n\n");
+	printf("--port        -p\tserial port of thermostat (default /dev/ttyUSB0)\n");
+	printf("--file        -f\tbinary image (default hr20.bin)\n");
+	printf("--window      -w\tpages sent without answer (default %d)\n", WINDOW);
+	printf("--reboot      -b\tsend command B1324 to application first,\n");
+	printf("              \t\totherwise reset thermostat after start\n");
+	printf("--verbose     -v\tprint communication\n");
+	printf("--help        -h\tthis help\n");
+}
+
+/*!
+ ********************************************************************************
+ * loadImage
+ *
+ * read binary image, pad it to full flash pages by 0xff
+ *
+ * \returns image length, 0 on error
+ *******************************************************************************/
+static int loadImage(const char *file, uint8_t *buf)
+{
+	FILE *f;
+	size_t n;
+
+	f = fopen(file, "rb");
+	if (f == NULL)
+	{
+		perror(file);
+		return 0;
+	}
+	memset(buf, 0xff, DELTA_FLASH);
+	n = fread(buf, 1, DELTA_FLASH, f);
+	if ((n == 0) || (fgetc(f) != EOF))
+	{
+		fprintf(stderr, "%s: image must have 1 .. %d bytes\n", file, DELTA_FLASH);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+	return n;
+}
+
+/*!
+ ********************************************************************************
+ * setSpeed
+ *
+ * raw mode 8n1, 9600 for application (COM_BAUD_RATE in src/config.h),
+ * 38400 for bootloader (STREAMBAUD in bootcfg.h)
+ *******************************************************************************/
+static void setSpeed(speed_t speed)
+{
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) == 0)
+	{
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSADRAIN, &tio);
+	}
+	tcflush(fd, TCIFLUSH);
+}
+
+static long now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+static void sendData(const uint8_t *d, int len)
+{
+	if (verbose)
+		fprintf(stderr, " > %c (%d bytes)\n", d[0], len);
+	if (write(fd, d, len) != len)
+		perror("write");
+}
+
+/*!
+ ********************************************************************************
+ * receive
+ *
+ * \returns byte, -1 on timeout
+ *******************************************************************************/
+static int receive(int ms)
+{
+	fd_set fds;
+	struct timeval tv = { ms / 1000, (ms % 1000) * 1000 };
+	uint8_t ch;
+
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	if ((select(fd + 1, &fds, NULL, NULL, &tv) <= 0) || (read(fd, &ch, 1) != 1))
+		return -1;
+	return ch;
+}
+
+/*!
+ ********************************************************************************
+ * resync
+ *
+ * complete frame of bootloader in case bytes were lost, wait until it drops
+ * rest of stream
+ *******************************************************************************/
+static void resync(void)
+{
+	uint8_t fill[FRAME];
+
+	memset(fill, 0xff, sizeof(fill));
+	sendData(fill, sizeof(fill));
+	tcdrain(fd);
+	usleep(SILENCE * 1000);
+	tcflush(fd, TCIFLUSH);
+}
+
+/*!
+ ********************************************************************************
+ * connectBoot
+ *
+ * password starts streaming mode of bootloader, 'S' is answered in it
+ *
+ * \returns pages of application section, 0 on timeout
+ *******************************************************************************/
+static int connectBoot(void)
+{
+	static const uint8_t hello[] = { 'S', KEY };
+	long start = now();
+
+	while (now() - start < TIMEOUT_CONNECT)
+	{
+		int c;
+
+		if (write(fd, hello, sizeof(hello)) != sizeof(hello))
+			perror("write");
+		while ((c = receive(50)) >= 0)
+		{
+			if (c != 'S')
+				continue;
+			c = receive(100);
+			if ((c > 0) && (c <= OTA_PAGES_MAX))
+			{
+				usleep(100000);         // rest of password
+				tcflush(fd, TCIFLUSH);
+				return c;
+			}
+		}
+	}
+	return 0;
+}
+
+/*!
+ ********************************************************************************
+ * readCrc
+ *
+ * CRC16 of every page in flash, bootloader finishes pending writes first
+ *
+ * \returns 1 on success
+ *******************************************************************************/
+static int readCrc(int n)
+{
+	static const uint8_t cmd = 'C';
+	int i, c;
+
+	sendData(&cmd, 1);
+	do
+	{
+		c = receive(TIMEOUT_ANSWER);
+	}
+	while ((c >= 0) && (c != 'C'));
+	for (i = 0; (c >= 0) && (i < n); i++)
+	{
+		int h = receive(TIMEOUT_ANSWER);
+		c = receive(TIMEOUT_ANSWER);
+		flash_crc[i] = (h << 8) | c;
+		if (h < 0)
+			c = -1;
+	}
+	return c >= 0;
+}
+
+/*!
+ ********************************************************************************
+ * sendPages
+ *
+ * stream pages with window, on error continue from failed page
+ *
+ * \returns 1 on success
+ *******************************************************************************/
+static int sendPages(const int *list, int n, int window)
+{
+	int next = 0;
+	int acked = 0;
+	int errors = 0;
+
+	while (acked < n)
+	{
+		int a, p;
+
+		while ((next < n) && (next - acked < window))
+		{
+			uint8_t frame[FRAME];
+			uint16_t c;
+
+			frame[0] = 'P';
+			frame[1] = list[next];
+			memcpy(frame + 2, image + list[next] * PAGE, PAGE);
+			c = deltaCrc(frame + 1, 1 + PAGE);
+			frame[FRAME - 2] = c >> 8;
+			frame[FRAME - 1] = c & 0xff;
+			sendData(frame, FRAME);
+			next++;
+		}
+		a = receive(TIMEOUT_ANSWER);
+		p = receive(TIMEOUT_ANSWER);
+		if (verbose)
+			fprintf(stderr, " < %c %d\n", a, p);
+		if ((a == 'A') && (p == list[acked]))
+		{
+			acked++;
+			printf("\rpage %3d/%d", acked, n);
+			fflush(stdout);
+			continue;
+		}
+		if (++errors > MAX_ERRORS)
+			return 0;
+		if (verbose)
+			fprintf(stderr, "error on page %d, resend\n", list[acked]);
+		resync();
+		next = acked;
+	}
+	printf("\n");
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	const char *port = "/dev/ttyUSB0";
+	const char *file = "hr20.bin";
+	int window = WINDOW;
+	int reboot = 0;
+	int list[OTA_PAGES_MAX];
+	int len, n, i, round;
+	int flash_pages;
+	long start;
+	int c;
+	int option_index = 0;
+	static const uint8_t end = 'E';
+
+	while ((c = getopt_long(argc, argv, "p:f:w:bvh", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+		case 'p':
+			port = optarg;
+			break;
+		case 'f':
+			file = optarg;
+			break;
+		case 'w':
+			window = atoi(optarg);
+			break;
+		case 'b':
+			reboot = 1;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+	}
+	if (window < 1)
+		window = 1;
+	len = loadImage(file, image);
+	if (len <= 0)
+		return EXIT_FAILURE;
+	pages = (len + PAGE - 1) / PAGE;
+	printf("%s: %d bytes, %d pages, CRC %04x\n", file, len, pages, deltaCrc(image, pages * PAGE));
+
+	fd = open(port, O_RDWR | O_NOCTTY);
+	if (fd < 0)
+	{
+		perror(port);
+		return EXIT_FAILURE;
+	}
+	if (reboot)
+	{
+		// first byte wakes up serial port of application
+		setSpeed(B9600);
+		sendData((const uint8_t *)"\n", 1);
+		usleep(100000);
+		sendData((const uint8_t *)"B1324\n", 6);
+		tcdrain(fd);
+	}
+	setSpeed(B38400);
+	printf("waiting for bootloader%s\n", reboot ? "" : ", reset thermostat");
+	flash_pages = connectBoot();
+	if (flash_pages == 0)
+	{
+		fprintf(stderr, "no answer of bootloader\n");
+		return EXIT_FAILURE;
+	}
+	if (pages > flash_pages)
+	{
+		fprintf(stderr, "image is larger than application section (%d pages)\n", flash_pages);
+		return EXIT_FAILURE;
+	}
+
+	start = now();
+	for (round = 0; round < MAX_ROUNDS; round++)
+	{
+		if (!readCrc(flash_pages))
+		{
+			fprintf(stderr, "no CRC from bootloader\n");
+			return EXIT_FAILURE;
+		}
+		for (i = n = 0; i < pages; i++)
+		{
+			if (flash_crc[i] != deltaCrc(image + i * PAGE, PAGE))
+				list[n++] = i;
+		}
+		if (n == 0)
+			break;
+		printf("%d of %d pages differ\n", n, pages);
+		if (!sendPages(list, n, window))
+		{
+			fprintf(stderr, "\ntoo many errors, start again to continue\n");
+			return EXIT_FAILURE;
+		}
+	}
+	if (round == MAX_ROUNDS)
+	{
+		fprintf(stderr, "flash check failed\n");
+		return EXIT_FAILURE;
+	}
+	sendData(&end, 1);
+	if (receive(TIMEOUT_ANSWER) != 'E')
+		fprintf(stderr, "no answer to end, application may not be started\n");
+	printf("done in %.1f s\n", (now() - start) / 1000.0);
+	close(fd);
+	return EXIT_SUCCESS;
+}
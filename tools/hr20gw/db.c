@@ -0,0 +1,584 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	db.c
+ * \brief	batched sqlite access for hr20gw
+ *
+ * All statements are prepared once at start. Writes are collected into one
+ * transaction which is committed on sync window end (see hr20gw.c) or when
+ * it is older than max_batch seconds.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sqlite3.h>
+
+#include "db.h"
+
+static sqlite3 *db = NULL;
+static int in_transaction = 0;
+static time_t batch_start;
+static int batch_max = 30;
+static int debug_lines = 1000;
+
+static sqlite3_stmt *st_begin;
+static sqlite3_stmt *st_commit;
+static sqlite3_stmt *st_log;
+static sqlite3_stmt *st_latest_update;
+static sqlite3_stmt *st_latest_insert;
+static sqlite3_stmt *st_rollup_insert[2];
+static sqlite3_stmt *st_rollup_update[2];
+static sqlite3_stmt *st_retention[3];
+static sqlite3_stmt *st_update[DB_TABLES];
+static sqlite3_stmt *st_insert[DB_TABLES];
+static sqlite3_stmt *st_version_update;
+static sqlite3_stmt *st_version_insert;
+static sqlite3_stmt *st_debug;
+static sqlite3_stmt *st_debug_trim;
+static sqlite3_stmt *st_queue_done;
+static sqlite3_stmt *st_queue_add;
+static sqlite3_stmt *st_queue_select;
+static sqlite3_stmt *st_queue_send;
+static sqlite3_stmt *st_queue_stat;
+
+static const char *table_names[DB_TABLES] = { "eeprom", "timers", "trace" };
+static const char *rollup_names[2] = { "log_hourly", "log_daily" };
+static const char *retention_names[3] = { "log", "log_hourly", "log_daily" };
+
+/*!
+ ********************************************************************************
+ * prepare
+ *
+ * \param *sql statement
+ * \param **st returns prepared statement
+ * \returns 1 on success
+ *******************************************************************************/
+static int prepare(const char *sql, sqlite3_stmt **st)
+{
+	if (sqlite3_prepare_v2(db, sql, -1, st, NULL) != SQLITE_OK)
+	{
+		fprintf(stderr, "sqlite: %s\n  %s\n", sqlite3_errmsg(db), sql);
+		return 0;
+	}
+	return 1;
+}
+
+/*!
+ ********************************************************************************
+ * run
+ *
+ * execute statement without result rows and reset it for next use
+ *******************************************************************************/
+static void run(sqlite3_stmt *st)
+{
+	if (sqlite3_step(st) != SQLITE_DONE)
+		fprintf(stderr, "sqlite: %s\n", sqlite3_errmsg(db));
+	sqlite3_reset(st);
+	sqlite3_clear_bindings(st);
+}
+
+/*!
+ ********************************************************************************
+ * touch
+ *
+ * open batch transaction if it is not open yet
+ *******************************************************************************/
+static void touch(void)
+{
+	if (!in_transaction)
+	{
+		run(st_begin);
+		in_transaction = 1;
+		batch_start = time(NULL);
+	}
+}
+
+/*!
+ ********************************************************************************
+ * dbOpen
+ *
+ * open database and prepare all statements
+ *
+ * \param *file sqlite database created by create_db.php
+ * \param max_batch maximal age of open transaction in seconds
+ * \param max_debug_lines number of lines kept in debug_log
+ * \returns 1 on success
+ *******************************************************************************/
+int dbOpen(const char *file, int max_batch, int max_debug_lines)
+{
+	char sql[400];
+	int i;
+
+	batch_max = max_batch;
+	debug_lines = max_debug_lines;
+	if (sqlite3_open(file, &db) != SQLITE_OK)
+	{
+		fprintf(stderr, "sqlite: can't open %s\n", file);
+		return 0;
+	}
+	// web frontend writes into command_queue, wait for it
+	sqlite3_busy_timeout(db, 5000);
+	sqlite3_exec(db, "PRAGMA synchronous=OFF", NULL, NULL, NULL);
+
+	if (!prepare("BEGIN TRANSACTION", &st_begin)
+	    || !prepare("COMMIT TRANSACTION", &st_commit)
+	    || !prepare("INSERT INTO log (time,addr,mode,valve,real,wanted,battery,error,window,force)"
+			" VALUES (?,?,?,?,?,?,?,?,?,?)", &st_log)
+	    || !prepare("UPDATE log_latest SET time=?1,mode=?3,valve=?4,real=?5,wanted=?6,battery=?7,"
+			"error=?8,window=?9,force=?10 WHERE addr=?2 AND time<=?1", &st_latest_update)
+	    || !prepare("INSERT OR IGNORE INTO log_latest (time,addr,mode,valve,real,wanted,battery,error,window,force)"
+			" VALUES (?,?,?,?,?,?,?,?,?,?)", &st_latest_insert)
+	    || !prepare("UPDATE versions SET time=?,data=? WHERE addr=?", &st_version_update)
+	    || !prepare("INSERT INTO versions (addr,time,data) VALUES (?,?,?)", &st_version_insert)
+	    || !prepare("INSERT INTO debug_log (time,addr,data) VALUES (?,?,?)", &st_debug)
+	    || !prepare("DELETE FROM debug_log WHERE id<=(SELECT max(id) FROM debug_log)-?", &st_debug_trim)
+	    || !prepare("DELETE FROM command_queue WHERE id=(SELECT id FROM command_queue"
+			" WHERE addr=? AND send>0 ORDER BY send LIMIT 1)", &st_queue_done)
+	    || !prepare("INSERT INTO command_queue (time,addr,data) VALUES (?,?,?)", &st_queue_add)
+	    || !prepare("SELECT id,data FROM command_queue WHERE addr=? ORDER BY time LIMIT 25", &st_queue_select)
+	    || !prepare("UPDATE command_queue SET send=? WHERE id=?", &st_queue_send)
+	    || !prepare("SELECT addr,count(*) AS c FROM command_queue GROUP BY addr ORDER BY c", &st_queue_stat))
+		return 0;
+	for (i = 0; i < DB_TABLES; i++)
+	{
+		snprintf(sql, sizeof(sql), "UPDATE %s SET time=?,value=? WHERE addr=? AND idx=?", table_names[i]);
+		if (!prepare(sql, &st_update[i]))
+			return 0;
+		snprintf(sql, sizeof(sql), "INSERT INTO %s (time,addr,idx,value) VALUES (?,?,?,?)", table_names[i]);
+		if (!prepare(sql, &st_insert[i]))
+			return 0;
+	}
+	for (i = 0; i < 2; i++)
+	{
+		snprintf(sql, sizeof(sql), "INSERT OR IGNORE INTO %s (addr,time,real_min,real_max,valve_min,valve_max,battery_min)"
+			 " VALUES (?1,?2,?3,?3,?4,?4,?5)", rollup_names[i]);
+		if (!prepare(sql, &st_rollup_insert[i]))
+			return 0;
+		snprintf(sql, sizeof(sql), "UPDATE %s SET n=n+1,"
+			 "real_min=min(real_min,?3),real_max=max(real_max,?3),real_sum=real_sum+?3,"
+			 "wanted_sum=wanted_sum+?6,"
+			 "valve_min=min(valve_min,?4),valve_max=max(valve_max,?4),valve_sum=valve_sum+?4,"
+			 "battery_min=min(battery_min,?5),window_sum=window_sum+?7"
+			 " WHERE addr=?1 AND time=?2", rollup_names[i]);
+		if (!prepare(sql, &st_rollup_update[i]))
+			return 0;
+	}
+	for (i = 0; i < 3; i++)
+	{
+		snprintf(sql, sizeof(sql), "DELETE FROM %s WHERE time<?", retention_names[i]);
+		if (!prepare(sql, &st_retention[i]))
+			return 0;
+	}
+	return 1;
+}
+
+/*!
+ ********************************************************************************
+ * dbClose
+ *
+ * commit pending data and close database
+ *******************************************************************************/
+void dbClose(void)
+{
+	sqlite3_stmt *st;
+
+	if (db == NULL)
+		return;
+	dbCommit();
+	while ((st = sqlite3_next_stmt(db, NULL)) != NULL)
+		sqlite3_finalize(st);
+	sqlite3_close(db);
+	db = NULL;
+}
+
+/*!
+ ********************************************************************************
+ * dbCommit
+ *
+ * trim debug_log and commit batch
+ *******************************************************************************/
+void dbCommit(void)
+{
+	if (!in_transaction)
+		return;
+	// trim once per batch, not for each debug line
+	sqlite3_bind_int(st_debug_trim, 1, debug_lines);
+	run(st_debug_trim);
+	run(st_commit);
+	in_transaction = 0;
+}
+
+/*!
+ ********************************************************************************
+ * dbCommitIfDue
+ *
+ * commit batch older than max_batch seconds
+ *
+ * \param now current time
+ *******************************************************************************/
+void dbCommitIfDue(time_t now)
+{
+	if (in_transaction && (now - batch_start >= batch_max))
+		dbCommit();
+}
+
+/*!
+ ********************************************************************************
+ * bind_opt
+ *
+ * bind integer or NULL for negative values
+ *******************************************************************************/
+static void bind_opt(sqlite3_stmt *st, int idx, int value)
+{
+	if (value < 0)
+		sqlite3_bind_null(st, idx);
+	else
+		sqlite3_bind_int(st, idx, value);
+}
+
+/*!
+ ********************************************************************************
+ * bind_status
+ *
+ * bind status to log / log_latest statement (same parameter order)
+ *******************************************************************************/
+static void bind_status(sqlite3_stmt *st, const db_status_t *s)
+{
+	sqlite3_bind_int64(st, 1, s->time);
+	sqlite3_bind_int(st, 2, s->addr);
+	if (s->mode)
+		sqlite3_bind_text(st, 3, s->mode, -1, SQLITE_STATIC);
+	bind_opt(st, 4, s->valve);
+	bind_opt(st, 5, s->real);
+	bind_opt(st, 6, s->wanted);
+	bind_opt(st, 7, s->battery);
+	// columns with DEFAULT 0
+	sqlite3_bind_int(st, 8, s->error < 0 ? 0 : s->error);
+	sqlite3_bind_int(st, 9, s->window < 0 ? 0 : s->window);
+	sqlite3_bind_int(st, 10, s->force < 0 ? 0 : s->force);
+}
+
+/*!
+ ********************************************************************************
+ * local_day
+ *
+ * \returns begin of local day (bucket of log_daily)
+ *******************************************************************************/
+static time_t local_day(time_t t)
+{
+	struct tm tm;
+
+	localtime_r(&t, &tm);
+	tm.tm_hour = 0;
+	tm.tm_min = 0;
+	tm.tm_sec = 0;
+	tm.tm_isdst = -1;
+	return mktime(&tm);
+}
+
+/*!
+ ********************************************************************************
+ * dbLogStatus
+ *
+ * insert status record into log table, update log_latest and rollups
+ *
+ * \param *st status, negative values are stored as NULL
+ *******************************************************************************/
+void dbLogStatus(const db_status_t *st)
+{
+	time_t bucket[2];
+	int i;
+
+	touch();
+	bind_status(st_log, st);
+	run(st_log);
+
+	bind_status(st_latest_update, st);
+	run(st_latest_update);
+	if (sqlite3_changes(db) == 0)
+	{
+		bind_status(st_latest_insert, st);
+		run(st_latest_insert);
+	}
+
+	bucket[0] = (st->time / 3600) * 3600;
+	bucket[1] = local_day(st->time);
+	for (i = 0; i < 2; i++)
+	{
+		sqlite3_stmt *ins = st_rollup_insert[i];
+		sqlite3_stmt *upd = st_rollup_update[i];
+
+		sqlite3_bind_int(ins, 1, st->addr);
+		sqlite3_bind_int64(ins, 2, bucket[i]);
+		sqlite3_bind_int(ins, 3, st->real < 0 ? 0 : st->real);
+		sqlite3_bind_int(ins, 4, st->valve < 0 ? 0 : st->valve);
+		sqlite3_bind_int(ins, 5, st->battery < 0 ? 0 : st->battery);
+		run(ins);
+		sqlite3_bind_int(upd, 1, st->addr);
+		sqlite3_bind_int64(upd, 2, bucket[i]);
+		sqlite3_bind_int(upd, 3, st->real < 0 ? 0 : st->real);
+		sqlite3_bind_int(upd, 4, st->valve < 0 ? 0 : st->valve);
+		sqlite3_bind_int(upd, 5, st->battery < 0 ? 0 : st->battery);
+		sqlite3_bind_int(upd, 6, st->wanted < 0 ? 0 : st->wanted);
+		sqlite3_bind_int(upd, 7, st->window < 0 ? 0 : st->window);
+		run(upd);
+	}
+}
+
+/*!
+ ********************************************************************************
+ * dbRetention
+ *
+ * delete old records
+ *
+ * \param log_days days kept in log, 0 = forever
+ * \param hourly_days days kept in log_hourly, 0 = forever
+ * \param daily_days days kept in log_daily, 0 = forever
+ *******************************************************************************/
+void dbRetention(int log_days, int hourly_days, int daily_days)
+{
+	int days[3] = { log_days, hourly_days, daily_days };
+	time_t now = time(NULL);
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		if (days[i] > 0)
+		{
+			touch();
+			sqlite3_bind_int64(st_retention[i], 1, now - days[i] * 86400L);
+			run(st_retention[i]);
+		}
+	}
+}
+
+/*!
+ ********************************************************************************
+ * dbSetValue
+ *
+ * update or insert (addr, idx) value in eeprom/timers/trace table
+ *******************************************************************************/
+void dbSetValue(int table, int addr, int idx, int value)
+{
+	time_t now = time(NULL);
+
+	touch();
+	sqlite3_bind_int64(st_update[table], 1, now);
+	sqlite3_bind_int(st_update[table], 2, value);
+	sqlite3_bind_int(st_update[table], 3, addr);
+	sqlite3_bind_int(st_update[table], 4, idx);
+	run(st_update[table]);
+	if (sqlite3_changes(db) == 0)
+	{
+		sqlite3_bind_int64(st_insert[table], 1, now);
+		sqlite3_bind_int(st_insert[table], 2, addr);
+		sqlite3_bind_int(st_insert[table], 3, idx);
+		sqlite3_bind_int(st_insert[table], 4, value);
+		run(st_insert[table]);
+	}
+}
+
+/*!
+ ********************************************************************************
+ * dbSetVersion
+ *
+ * update or insert version string of thermostat
+ *******************************************************************************/
+void dbSetVersion(int addr, const char *data)
+{
+	time_t now = time(NULL);
+
+	touch();
+	sqlite3_bind_int64(st_version_update, 1, now);
+	sqlite3_bind_text(st_version_update, 2, data, -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int(st_version_update, 3, addr);
+	run(st_version_update);
+	if (sqlite3_changes(db) == 0)
+	{
+		sqlite3_bind_int(st_version_insert, 1, addr);
+		sqlite3_bind_int64(st_version_insert, 2, now);
+		sqlite3_bind_text(st_version_insert, 3, data, -1, SQLITE_TRANSIENT);
+		run(st_version_insert);
+	}
+}
+
+/*!
+ ********************************************************************************
+ * dbDebugLog
+ *
+ * store line into debug_log, old lines are removed on commit
+ *******************************************************************************/
+void dbDebugLog(int addr, const char *line)
+{
+	touch();
+	sqlite3_bind_int64(st_debug, 1, time(NULL));
+	sqlite3_bind_int(st_debug, 2, addr);
+	sqlite3_bind_text(st_debug, 3, line, -1, SQLITE_TRANSIENT);
+	run(st_debug);
+}
+
+/*!
+ ********************************************************************************
+ * dbQueueDone
+ *
+ * thermostat confirmed command ('*' reply), remove it from command_queue
+ *******************************************************************************/
+void dbQueueDone(int addr)
+{
+	touch();
+	sqlite3_bind_int(st_queue_done, 1, addr);
+	run(st_queue_done);
+}
+
+/*!
+ ********************************************************************************
+ * dbQueueAdd
+ *
+ * put command for thermostat into command_queue, like web frontend does
+ *******************************************************************************/
+void dbQueueAdd(int addr, const char *data)
+{
+	touch();
+	sqlite3_bind_int64(st_queue_add, 1, time(NULL));
+	sqlite3_bind_int(st_queue_add, 2, addr);
+	sqlite3_bind_text(st_queue_add, 3, data, -1, SQLITE_TRANSIENT);
+	run(st_queue_add);
+}
+
+/*!
+ ********************************************************************************
+ * weights
+ *
+ * air time weight of queued command, bank is limited to 10
+ *******************************************************************************/
+static int weights(char c)
+{
+	switch (c)
+	{
+	case 'S':
+	case 'W':
+	case 'Z':
+	case 'J':               // short command, long answer
+		return 4;
+	case 'G':
+	case 'R':
+	case 'T':
+	case 'N':
+		return 2;
+	default:
+		return 10;
+	}
+}
+
+/*!
+ ********************************************************************************
+ * dbQueueRequest
+ *
+ * master asks for commands for thermostat "(aa)?", create "(aa-b)X..." lines
+ *
+ * \param addr thermostat address
+ * \param *out output buffer for master
+ * \param size size of output buffer
+ * \returns length of output
+ *******************************************************************************/
+int dbQueueRequest(int addr, char *out, int size)
+{
+	int weight = 0;
+	int bank = 0;
+	int send = 0;
+	int n = 0;
+
+	touch();
+	sqlite3_bind_int(st_queue_select, 1, addr & 0x7f);
+	while (sqlite3_step(st_queue_select) == SQLITE_ROW)
+	{
+		int id = sqlite3_column_int(st_queue_select, 0);
+		const char *data = (const char *)sqlite3_column_text(st_queue_select, 1);
+		int cw;
+
+		if (data == NULL)
+			continue;
+		cw = weights(data[0]);
+		weight += cw;
+		if (weight > 10)
+		{
+			if (++bank >= 7)
+				break;
+			weight = cw;
+		}
+		if (n < size)
+			n += snprintf(out + n, size - n, "(%02x-%x)%s\n", addr, bank, data);
+		send++;
+		sqlite3_bind_int(st_queue_send, 1, send);
+		sqlite3_bind_int(st_queue_send, 2, id);
+		run(st_queue_send);
+	}
+	sqlite3_reset(st_queue_select);
+	sqlite3_clear_bindings(st_queue_select);
+	return n < size ? n : size - 1;
+}
+
+/*!
+ ********************************************************************************
+ * dbQueueSchedule
+ *
+ * reply for "N0?" / "N1?", tell master which thermostats have waiting commands
+ *
+ * \param n1 1 for "N1?"
+ * \param *out output buffer for master
+ * \param size size of output buffer
+ * \returns length of output
+ *******************************************************************************/
+int dbQueueSchedule(int n1, char *out, int size)
+{
+	int req[4] = { 0, 0, 0, 0 };
+	int force = -1;
+	int pr = 0;
+	int have_rows = 0;
+
+	while (sqlite3_step(st_queue_stat) == SQLITE_ROW)
+	{
+		int addr = sqlite3_column_int(st_queue_stat, 0);
+		int c = sqlite3_column_int(st_queue_stat, 1);
+
+		if ((addr > 0) && (addr < 30))
+		{
+			have_rows = 1;
+			force = -1;
+			if (n1 && (c > 20))
+			{
+				force = addr;
+				snprintf(out, size, "O%02x%02x\n", addr, pr);
+				pr = addr;
+				continue;
+			}
+			req[addr / 8] |= 1 << (addr % 8);
+		}
+	}
+	sqlite3_reset(st_queue_stat);
+	if (!have_rows)
+		return snprintf(out, size, "O0000\n");
+	if (force < 0)
+		return snprintf(out, size, "P%02x%02x%02x%02x\n", req[0], req[1], req[2], req[3]);
+	return strlen(out);
+}
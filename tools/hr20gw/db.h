@@ -0,0 +1,70 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	db.h
+ * \brief	batched sqlite access for hr20gw, same schema as frontend/tools/create_db.php
+ */
+
+#ifndef __DB_H__
+#define __DB_H__
+
+#include <time.h>
+
+/*! tables with (addr, idx, value) rows */
+enum
+{
+	DB_TABLE_EEPROM = 0,    //!< 'G', 'S'
+	DB_TABLE_TIMERS,        //!< 'R', 'W'
+	DB_TABLE_TRACE,         //!< 'T', 'J'
+	DB_TABLES
+};
+
+/*! one row for log table, negative value = column is not present (NULL) */
+typedef struct
+{
+	int addr;
+	time_t time;
+	const char *mode;
+	int valve;
+	int real;
+	int wanted;
+	int battery;
+	int error;
+	int window;
+	int force;
+} db_status_t;
+
+extern int dbOpen(const char *file, int max_batch, int max_debug_lines);
+extern void dbClose(void);
+extern void dbCommit(void);
+extern void dbCommitIfDue(time_t now);
+extern void dbLogStatus(const db_status_t *st);
+extern void dbRetention(int log_days, int hourly_days, int daily_days);
+extern void dbSetValue(int table, int addr, int idx, int value);
+extern void dbSetVersion(int addr, const char *data);
+extern void dbDebugLog(int addr, const char *line);
+extern void dbQueueDone(int addr);
+extern void dbQueueAdd(int addr, const char *data);
+extern int dbQueueRequest(int addr, char *out, int size);
+extern int dbQueueSchedule(int n1, char *out, int size);
+
+#endif
@@ -0,0 +1,537 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20gw.c
+ * \brief	native gateway daemon, replacement for frontend/tools/daemon.php
+ *
+ * Reads master serial stream (text or binary mode, see tools/hr20bin),
+ * serves RTC and command queue requests and stores data into the same
+ * sqlite database as daemon.php. Writes are grouped into one transaction
+ * per master sync window (commit on "N0?"/"N1?"/"RTC?"), status records
+ * are written to rrd files without fork for each record.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <signal.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/select.h>
+
+#include "hr20bin.h"
+#include "db.h"
+#include "tsdb.h"
+
+#define HR20GW_VERSION "0.1"
+
+static int fd_in = -1;
+static int fd_out = -1;
+static int verbose = 0;
+static int cur_addr = 0;
+static volatile sig_atomic_t quit = 0;
+static int keep_days[3] = { 90, 730, 0 };      // log, log_hourly, log_daily
+static time_t retention_time = 0;
+static uint16_t trace_mask[0x80];               // last 'Z' answer of thermostat
+
+static struct option long_options[] =
+{
+	{"port", required_argument, 0, 'p'},
+	{"database", required_argument, 0, 'd'},
+	{"rrd_home", required_argument, 0, 'r'},
+	{"batch", required_argument, 0, 'b'},
+	{"keep", required_argument, 0, 'k'},
+	{"text", no_argument, 0, 't'},
+	{"verbose", no_argument, 0, 'v'},
+	{"help", no_argument, 0, 'h'},
+	{0, 0, 0, 0}
+};
+
+static void printUsage(void)
+{
+	printf("hr20gw version %s\n", HR20GW_VERSION);
+	printf("\nOptions:\n\n");
+	printf("--port        -p\tserial port of master (default /dev/ttyUSB0), - for stdin/stdout\n");
+	printf("--database    -d\tsqlite database (default /tmp/openhr20.sqlite)\n");
+	printf("--rrd_home    -r\tdirectory with rrd files (default /tmp/openhr20/)\n");
+	printf("--batch       -b\tmaximal seconds between commits (default 30)\n");
+	printf("--keep        -k\tdays kept in log,log_hourly,log_daily, 0 = forever (default 90,730,0)\n");
+	printf("--text        -t\tdon't switch master into binary dump mode\n");
+	printf("--verbose     -v\tprint communication\n");
+	printf("--help        -h\tthis help\n");
+}
+
+static void sigHandler(int sig)
+{
+	(void)sig;
+	quit = 1;
+}
+
+/*!
+ ********************************************************************************
+ * openSerial
+ *
+ * open master port, raw mode 38400 8n1 (COM_BAUD_RATE in rfm-master/config.h)
+ *
+ * \param *device device name or "-"
+ * \returns 1 on success
+ *******************************************************************************/
+static int openSerial(const char *device)
+{
+	struct termios tio;
+
+	if (strcmp(device, "-") == 0)
+	{
+		fd_in = STDIN_FILENO;
+		fd_out = STDOUT_FILENO;
+		return 1;
+	}
+	fd_in = open(device, O_RDWR | O_NOCTTY);
+	if (fd_in < 0)
+	{
+		perror(device);
+		return 0;
+	}
+	fd_out = fd_in;
+	if (tcgetattr(fd_in, &tio) == 0)
+	{
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B38400);
+		cfsetospeed(&tio, B38400);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcflush(fd_in, TCIFLUSH);
+		tcsetattr(fd_in, TCSANOW, &tio);
+	}
+	return 1;
+}
+
+static void sendMaster(const char *s, int len)
+{
+	if (verbose)
+		printf(" > %.*s", len, s);
+	if (write(fd_out, s, len) != len)
+		perror("write");
+}
+
+/*!
+ ********************************************************************************
+ * sendRTC
+ *
+ * send current date and time to master
+ *******************************************************************************/
+static void sendRTC(void)
+{
+	struct timeval tv;
+	struct tm tm;
+	char buf[40];
+	int n;
+
+	gettimeofday(&tv, NULL);
+	localtime_r(&tv.tv_sec, &tm);
+	n = snprintf(buf, sizeof(buf), "Y%02x%02x%02x\nH%02x%02x%02x%02x\n",
+		     tm.tm_year - 100, tm.tm_mon + 1, tm.tm_mday,
+		     tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(tv.tv_usec / 10000));
+	sendMaster(buf, n);
+}
+
+/*!
+ ********************************************************************************
+ * parseTextRecord
+ *
+ * parse record line of master text dump (without '*' / '-' mark)
+ *
+ * \returns 1 if line is known record
+ *******************************************************************************/
+static int parseTextRecord(const char *data, hr20bin_record_t *rec)
+{
+	unsigned int a, b, v, i, s, bat, e;
+	int pos = 0;
+	char mode;
+
+	memset(rec, 0, sizeof(*rec));
+	rec->cmd = data[0];
+	switch (data[0])
+	{
+	case 'D':
+	case 'A':
+	case 'M':
+		if (sscanf(data + 1, " m%u s%u %c V%u I%u S%u B%u E%x",
+			   &a, &b, &mode, &v, &i, &s, &bat, &e) != 8)
+			return 0;
+		rec->u.status.min = a;
+		rec->u.status.sec = b;
+		rec->u.status.mode_auto = (mode != 'M');
+		rec->u.status.test_auto = (mode == 'A');
+		rec->u.status.valve = v;
+		rec->u.status.temp_average = i;
+		rec->u.status.temp_wanted = s;
+		rec->u.status.bat_average = bat;
+		rec->u.status.error = e;
+		rec->u.status.window_open = (strstr(data, " W") != NULL);
+		rec->u.status.locked = (strstr(data, " L") != NULL);
+		return 1;
+	case 'T':
+	case 'R':
+	case 'W':
+	case 'Z':
+	case 'G':
+	case 'S':
+	case 'N':
+		if (sscanf(data + 1, "[%x]=%x", &a, &b) != 2)
+			return 0;
+		if ((data[0] == 'G') || (data[0] == 'S'))
+		{
+			rec->u.byte.idx = a;
+			rec->u.byte.value = b;
+		}
+		else
+		{
+			rec->u.word.idx = a;
+			rec->u.word.value = b;
+		}
+		return 1;
+	case 'J':
+		if ((sscanf(data + 1, "[%x]=%n", &a, &pos) != 1) || (pos == 0))
+			return 0;
+		rec->u.trace.seq = a;
+		for (data += 1 + pos; (rec->u.trace.len < HR20BIN_TRACE_MAX) && (sscanf(data, "%4x", &b) == 1); data += 4)
+			rec->u.trace.value[rec->u.trace.len++] = b;
+		return 1;
+	case 'V':
+		rec->u.raw.len = strnlen(data + 1, sizeof(rec->u.raw.data) - 1);
+		memcpy(rec->u.raw.data, data + 1, rec->u.raw.len);
+		rec->u.raw.data[rec->u.raw.len] = '\0';
+		return 1;
+	case 'L':
+		if (sscanf(data + 1, "%x", &a) != 1)
+			return 0;
+		rec->u.value = a;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/*!
+ ********************************************************************************
+ * storeTrace
+ *
+ * split 'J' answer into records by mask of 'Z' answer, latest values go to
+ * trace table, next fetch is queued while trace is on
+ *******************************************************************************/
+static void storeTrace(int addr, const hr20bin_record_t *rec)
+{
+	uint16_t mask;
+	char cmd[8];
+	int words = 0;
+	int n = 0;
+	int seq, i;
+
+	if (!rec->reply || (addr >= 0x80) || ((mask = trace_mask[addr]) == 0))
+		return;
+	for (i = 0; i < 16; i++)
+		words += (mask >> i) & 1;
+	for (seq = rec->u.trace.seq; n + words <= rec->u.trace.len; seq++)
+	{
+		for (i = 0; i < 16; i++)
+		{
+			if (mask & (1 << i))
+				dbSetValue(DB_TABLE_TRACE, addr, i, rec->u.trace.value[n++]);
+		}
+	}
+	snprintf(cmd, sizeof(cmd), "J%02x", seq & 0xff);
+	dbQueueAdd(addr, cmd);
+}
+
+/*!
+ ********************************************************************************
+ * storeRecord
+ *
+ * store decoded record from thermostat addr
+ *******************************************************************************/
+static void storeRecord(int addr, const hr20bin_record_t *rec)
+{
+	db_status_t st;
+	char v[HR20BIN_MAX_PAYLOAD + 2];
+	time_t now;
+	int t;
+
+	if (addr <= 0)
+		return;
+	if (rec->reply)
+		dbQueueDone(addr);
+	switch (rec->cmd)
+	{
+	case 'D':
+	case 'A':
+		t = rec->u.status.min * 60 + rec->u.status.sec;
+		now = time(NULL);
+		if ((now % 3600) < t)
+			now -= 3600;
+		st.addr = addr;
+		st.time = (now / 3600) * 3600 + t;
+		st.mode = rec->u.status.mode_auto ? (rec->u.status.test_auto ? "AUTO" : "-") : "MANU";
+		st.valve = rec->u.status.valve;
+		st.real = rec->u.status.temp_average;
+		st.wanted = rec->u.status.temp_wanted;
+		st.battery = rec->u.status.bat_average;
+		st.error = rec->u.status.error;
+		st.window = rec->u.status.window_open;
+		st.force = rec->reply;
+		dbLogStatus(&st);
+		tsdbUpdate(addr, st.time, st.real, st.wanted, st.valve, st.window);
+		break;
+	case 'G':
+	case 'S':
+		dbSetValue(DB_TABLE_EEPROM, addr, rec->u.byte.idx, rec->u.byte.value);
+		break;
+	case 'R':
+	case 'W':
+		dbSetValue(DB_TABLE_TIMERS, addr, rec->u.word.idx, rec->u.word.value);
+		break;
+	case 'T':
+		dbSetValue(DB_TABLE_TRACE, addr, rec->u.word.idx, rec->u.word.value);
+		break;
+	case 'Z':
+		if (rec->reply && (addr < 0x80))
+			trace_mask[addr] = rec->u.word.idx ? rec->u.word.value : 0;
+		break;
+	case 'J':
+		storeTrace(addr, rec);
+		break;
+	case 'V':
+		snprintf(v, sizeof(v), "V%.*s", rec->u.raw.len, rec->u.raw.data);
+		dbSetVersion(addr, v);
+		break;
+	default:
+		break;
+	}
+}
+
+/*!
+ ********************************************************************************
+ * endOfWindow
+ *
+ * master sync window is finished, store batch
+ *******************************************************************************/
+static void endOfWindow(void)
+{
+	dbCommit();
+	tsdbFlush();
+}
+
+/*!
+ ********************************************************************************
+ * handleLine
+ *
+ * process one text line from master
+ *******************************************************************************/
+static void handleLine(const char *line)
+{
+	hr20bin_record_t rec;
+	char out[1024];
+	int debug = 1;
+	int n;
+
+	if (line[0] == '\0')
+		return;
+	if (verbose)
+		printf(" < %s\n", line);
+	if ((line[0] == '(') && (strlen(line) >= 5) && (line[3] == ')'))
+	{
+		cur_addr = strtol(line + 1, NULL, 16);
+		if (line[4] == '?')
+		{
+			n = dbQueueRequest(cur_addr, out, sizeof(out));
+			if (n > 0)
+				sendMaster(out, n);
+			debug = 0;
+		}
+	}
+	else if ((line[0] == '*') || (line[0] == '-'))
+	{
+		if (parseTextRecord(line + 1, &rec))
+		{
+			rec.reply = (line[0] == '*');
+			storeRecord(cur_addr, &rec);
+		}
+		else if (line[0] == '*')
+			dbQueueDone(cur_addr);
+	}
+	else
+	{
+		cur_addr = 0;
+		if (strcmp(line, "RTC?") == 0)
+		{
+			sendRTC();
+			if (time(NULL) - retention_time >= 3600)
+			{
+				dbRetention(keep_days[0], keep_days[1], keep_days[2]);
+				retention_time = time(NULL);
+			}
+			endOfWindow();
+			debug = 0;
+		}
+		else if ((strcmp(line, "OK") == 0) || ((line[0] == 'd') && (line[1] != '\0') && (line[2] == ' ')))
+		{
+			debug = 0;
+		}
+		else if ((strcmp(line, "N0?") == 0) || (strcmp(line, "N1?") == 0))
+		{
+			n = dbQueueSchedule(line[1] == '1', out, sizeof(out));
+			sendMaster(out, n);
+			endOfWindow();
+			debug = 0;
+		}
+	}
+	if (debug)
+		dbDebugLog(cur_addr, line);
+	if (strcmp(line, "}") == 0)
+		cur_addr = 0;
+}
+
+/*!
+ ********************************************************************************
+ * handlePacket
+ *
+ * process binary record from master
+ *******************************************************************************/
+static void handlePacket(const hr20bin_packet_t *pkt)
+{
+	hr20bin_record_t rec;
+	char line[HR20BIN_MAX_LINE];
+	int offset = 0;
+	int ret;
+
+	if (verbose)
+		printf(" < PKT%04x (%02x) len %d\n", pkt->seq, pkt->addr, pkt->len);
+	while ((ret = hr20binNextRecord(pkt, &offset, &rec)) != 0)
+	{
+		hr20binFormatRecord(&rec, line, sizeof(line));
+		dbDebugLog(pkt->addr, line);
+		if (ret > 0)
+			storeRecord(pkt->addr, &rec);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *port = "/dev/ttyUSB0";
+	const char *database = "/tmp/openhr20.sqlite";
+	const char *rrd_home = "/tmp/openhr20/";
+	int batch = 30;
+	int binary = 1;
+	hr20bin_parser_t parser;
+	unsigned char buf[256];
+	int c;
+	int option_index = 0;
+
+	while ((c = getopt_long(argc, argv, "p:d:r:b:k:tvh", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+		case 'p':
+			port = optarg;
+			break;
+		case 'd':
+			database = optarg;
+			break;
+		case 'r':
+			rrd_home = optarg;
+			break;
+		case 'b':
+			batch = atoi(optarg);
+			break;
+		case 'k':
+			sscanf(optarg, "%d,%d,%d", &keep_days[0], &keep_days[1], &keep_days[2]);
+			break;
+		case 't':
+			binary = 0;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+	}
+
+	if (!dbOpen(database, batch, 1000))
+		return EXIT_FAILURE;
+	if (!tsdbOpen(rrd_home))
+		return EXIT_FAILURE;
+	if (!openSerial(port))
+		return EXIT_FAILURE;
+	signal(SIGINT, sigHandler);
+	signal(SIGTERM, sigHandler);
+	signal(SIGPIPE, SIG_IGN);
+
+	hr20binInit(&parser);
+	if (binary)
+		sendMaster("X01\n", 4);
+	sendRTC();
+
+	while (!quit)
+	{
+		fd_set fds;
+		struct timeval tv = { 1, 0 };
+		int n, i;
+
+		FD_ZERO(&fds);
+		FD_SET(fd_in, &fds);
+		n = select(fd_in + 1, &fds, NULL, NULL, &tv);
+		if (n > 0)
+		{
+			n = read(fd_in, buf, sizeof(buf));
+			if (n <= 0)
+				break;
+			for (i = 0; i < n; i++)
+			{
+				switch (hr20binFeed(&parser, buf[i]))
+				{
+				case HR20BIN_LINE:
+					handleLine(parser.line);
+					break;
+				case HR20BIN_PACKET:
+					handlePacket(&parser.pkt);
+					break;
+				case HR20BIN_ERROR:
+					dbDebugLog(0, "broken binary record");
+					break;
+				default:
+					break;
+				}
+			}
+		}
+		dbCommitIfDue(time(NULL));
+	}
+	dbClose();
+	tsdbClose();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	tsdb.c
+ * \brief	time series (rrdtool) updates for hr20gw
+ *
+ * With librrd (HAVE_RRD) files are updated in process by rrd_update_r().
+ * Without it one "rrdtool -" process is started and it gets all updates
+ * through pipe, instead of one rrdtool process for each status record.
+ * RRD files are created by frontend/tools/create_rrd.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef HAVE_RRD
+#include <rrd.h>
+#endif
+
+#include "tsdb.h"
+
+static char home[200];
+#ifndef HAVE_RRD
+static FILE *pipe_fp = NULL;
+#endif
+
+/*!
+ ********************************************************************************
+ * tsdbOpen
+ *
+ * \param *rrd_home directory with openhr20_<addr>.rrd files
+ * \returns 1 on success
+ *******************************************************************************/
+int tsdbOpen(const char *rrd_home)
+{
+	snprintf(home, sizeof(home), "%s", rrd_home);
+#ifndef HAVE_RRD
+	pipe_fp = popen("rrdtool - >/dev/null", "w");
+	if (pipe_fp == NULL)
+	{
+		perror("rrdtool");
+		return 0;
+	}
+#endif
+	return 1;
+}
+
+/*!
+ ********************************************************************************
+ * tsdbClose
+ *******************************************************************************/
+void tsdbClose(void)
+{
+#ifndef HAVE_RRD
+	if (pipe_fp != NULL)
+	{
+		fprintf(pipe_fp, "quit\n");
+		pclose(pipe_fp);
+		pipe_fp = NULL;
+	}
+#endif
+}
+
+/*!
+ ********************************************************************************
+ * tsdbUpdate
+ *
+ * add one status record, file which does not exist is skipped
+ *******************************************************************************/
+void tsdbUpdate(int addr, time_t time, int real, int wanted, int valve, int window)
+{
+	char file[256];
+	char value[80];
+
+	snprintf(file, sizeof(file), "%s/openhr20_%d.rrd", home, addr);
+	if (access(file, W_OK) != 0)
+		return;
+	snprintf(value, sizeof(value), "%ld:%d:%d:%d:%d", (long)time, real, wanted, valve, window);
+#ifdef HAVE_RRD
+	{
+		const char *argv[1] = { value };
+		rrd_clear_error();
+		if (rrd_update_r(file, NULL, 1, argv) != 0)
+			fprintf(stderr, "rrd: %s\n", rrd_get_error());
+	}
+#else
+	if (pipe_fp != NULL)
+		fprintf(pipe_fp, "update %s %s\n", file, value);
+#endif
+}
+
+/*!
+ ********************************************************************************
+ * tsdbFlush
+ *
+ * push buffered updates, called together with database commit
+ *******************************************************************************/
+void tsdbFlush(void)
+{
+#ifndef HAVE_RRD
+	if (pipe_fp != NULL)
+		fflush(pipe_fp);
+#endif
+}
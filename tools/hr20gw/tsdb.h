@@ -0,0 +1,37 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	tsdb.h
+ * \brief	time series (rrdtool) updates for hr20gw without fork per record
+ */
+
+#ifndef __TSDB_H__
+#define __TSDB_H__
+
+#include <time.h>
+
+extern int tsdbOpen(const char *rrd_home);
+extern void tsdbClose(void);
+extern void tsdbUpdate(int addr, time_t time, int real, int wanted, int valve, int window);
+extern void tsdbFlush(void);
+
+#endif
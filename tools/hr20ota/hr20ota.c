@@ -0,0 +1,424 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	hr20ota.c
+ * \brief	radio firmware update of thermostat through rfm-master
+ *
+ * Image is streamed block by block, master has no space for it. Next block
+ * is selected by answer of bootloader, see common/ota.h. With --base only
+ * patch from old image is sent (tools/hr20delta), bootloader falls back to
+ * full image when patch can't be used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/select.h>
+
+#include "ota.h"
+#include "delta.h"
+
+#define HR20OTA_VERSION "0.1"
+
+#define RETRY_BLOCK 1           //!< seconds without answer to repeat block
+#define RETRY_QUERY 2           //!< seconds between queries
+#define TIMEOUT_LINK 600        //!< seconds without answer to give up, same as bootloader
+#define MAX_CRC_ERRORS 3
+
+static int fd_in = -1;
+static int fd_out = -1;
+static int verbose = 0;
+
+static uint8_t image[DELTA_FLASH];
+static int pages = 0;
+static uint16_t crc = 0;
+
+static uint8_t patch[DELTA_MAX];
+static int patch_len = 0;
+static int chunk[OTA_PAGES_MAX + 2];
+static int chunks = 0;
+
+static struct option long_options[] =
+{
+	{"port", required_argument, 0, 'p'},
+	{"addr", required_argument, 0, 'a'},
+	{"file", required_argument, 0, 'f'},
+	{"base", required_argument, 0, 'b'},
+	{"resume", no_argument, 0, 'r'},
+	{"verbose", no_argument, 0, 'v'},
+	{"help", no_argument, 0, 'h'},
+	{0, 0, 0, 0}
+};
+
+static void printUsage(void)
+{
+	printf("hr20ota version %s\n", HR20OTA_VERSION);
+	printf("\nOptions:\n\n");
+	printf("--port        -p\tserial port of master (default /dev/ttyUSB0), - for stdin/stdout\n");
+	printf("--addr        -a\tthermostat address (hex)\n");
+	printf("--file        -f\tbinary image (default hr20.bin)\n");
+	printf("--base        -b\tbinary image in thermostat, send only delta\n");
+	printf("--resume      -r\tthermostat is already in bootloader, don't send command F\n");
+	printf("--verbose     -v\tprint communication\n");
+	printf("--help        -h\tthis help\n");
+}
+
+/*!
+ ********************************************************************************
+ * loadImage
+ *
+ * read binary image, pad it to full flash pages by 0xff
+ *
+ * \returns image length, 0 on error
+ *******************************************************************************/
+static int loadImage(const char *file, uint8_t *buf)
+{
+	FILE *f;
+	size_t n;
+
+	f = fopen(file, "rb");
+	if (f == NULL)
+	{
+		perror(file);
+		return 0;
+	}
+	memset(buf, 0xff, DELTA_FLASH);
+	n = fread(buf, 1, DELTA_FLASH, f);
+	if ((n == 0) || (fgetc(f) != EOF))
+	{
+		fprintf(stderr, "%s: image must have 1 .. %d bytes\n", file, DELTA_FLASH);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+	return n;
+}
+
+/*!
+ ********************************************************************************
+ * loadDelta
+ *
+ * create patch from base image, it is used only if it is shorter than image
+ *******************************************************************************/
+static void loadDelta(const char *file, int new_len)
+{
+	static uint8_t base[DELTA_FLASH];
+	int n = loadImage(file, base);
+
+	if (n <= 0)
+		return;
+	patch_len = deltaCreate(base, n, image, new_len, patch, sizeof(patch));
+	if (patch_len > 0)
+		chunks = deltaChunks(patch, patch_len, chunk, OTA_PAGES_MAX + 1);
+	if ((patch_len <= 0) || (chunks <= 0) || (chunk[chunks] - chunk[0] >= pages * OTA_PAGE))
+	{
+		printf("%s: delta is not usable, full image is sent\n", file);
+		patch_len = 0;
+		chunks = 0;
+		return;
+	}
+	printf("%s: delta %d bytes, %d changed pages\n", file, patch_len, chunks - 1);
+}
+
+/*!
+ ********************************************************************************
+ * openSerial
+ *
+ * open master port, raw mode 38400 8n1 (COM_BAUD_RATE in rfm-master/config.h)
+ *
+ * \param *device device name or "-"
+ * \returns 1 on success
+ *******************************************************************************/
+static int openSerial(const char *device)
+{
+	struct termios tio;
+
+	if (strcmp(device, "-") == 0)
+	{
+		fd_in = STDIN_FILENO;
+		fd_out = STDOUT_FILENO;
+		return 1;
+	}
+	fd_in = open(device, O_RDWR | O_NOCTTY);
+	if (fd_in < 0)
+	{
+		perror(device);
+		return 0;
+	}
+	fd_out = fd_in;
+	if (tcgetattr(fd_in, &tio) == 0)
+	{
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B38400);
+		cfsetospeed(&tio, B38400);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcflush(fd_in, TCIFLUSH);
+		tcsetattr(fd_in, TCSANOW, &tio);
+	}
+	return 1;
+}
+
+static void sendMaster(const char *s, int len)
+{
+	if (verbose)
+		fprintf(stderr, " > %.*s", len, s);
+	if (write(fd_out, s, len) != len)
+		perror("write");
+}
+
+/*!
+ ********************************************************************************
+ * sendRTC
+ *
+ * send current date and time to master, same as hr20gw
+ *******************************************************************************/
+static void sendRTC(void)
+{
+	struct timeval tv;
+	struct tm tm;
+	char buf[40];
+	int n;
+
+	gettimeofday(&tv, NULL);
+	localtime_r(&tv.tv_sec, &tm);
+	n = snprintf(buf, sizeof(buf), "Y%02x%02x%02x\nH%02x%02x%02x%02x\n",
+		     tm.tm_year - 100, tm.tm_mon + 1, tm.tm_mday,
+		     tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(tv.tv_usec / 10000));
+	sendMaster(buf, n);
+}
+
+/*!
+ ********************************************************************************
+ * sendBlock
+ *
+ * send one block of image to bootloader
+ *******************************************************************************/
+static void sendBlock(int addr, int page, int blk, const uint8_t *d)
+{
+	char buf[8 + 2 * OTA_BLOCK];
+	int n, i;
+
+	n = snprintf(buf, sizeof(buf), "F%02x%02x%02x", addr, page, blk);
+	for (i = 0; i < OTA_BLOCK; i++)
+		n += snprintf(buf + n, sizeof(buf) - n, "%02x", d[i]);
+	buf[n++] = '\n';
+	sendMaster(buf, n);
+}
+
+int main(int argc, char **argv)
+{
+	const char *port = "/dev/ttyUSB0";
+	const char *file = "hr20.bin";
+	const char *base = NULL;
+	const uint8_t *block = NULL;
+	int addr = -1;
+	int queued = 0;
+	int crc_errors = 0;
+	int page = -1;
+	int blk = 0;
+	time_t last_send = 0;
+	time_t last_answer;
+	char line[256];
+	int line_len = 0;
+	int len;
+	int c;
+	int option_index = 0;
+
+	while ((c = getopt_long(argc, argv, "p:a:f:b:rvh", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+		case 'p':
+			port = optarg;
+			break;
+		case 'a':
+			addr = strtol(optarg, NULL, 16);
+			break;
+		case 'f':
+			file = optarg;
+			break;
+		case 'b':
+			base = optarg;
+			break;
+		case 'r':
+			queued = 1;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+	}
+	if ((addr <= 0) || (addr > 29))
+	{
+		fprintf(stderr, "thermostat address 01 .. 1d is needed (--addr)\n");
+		return EXIT_FAILURE;
+	}
+	len = loadImage(file, image);
+	if (len <= 0)
+		return EXIT_FAILURE;
+	pages = (len + OTA_PAGE - 1) / OTA_PAGE;
+	crc = deltaCrc(image, pages * OTA_PAGE);
+	printf("%s: %d bytes, %d pages, CRC %04x\n", file, len, pages, crc);
+	if (base != NULL)
+		loadDelta(base, len);
+	if (!openSerial(port))
+		return EXIT_FAILURE;
+
+	last_answer = time(NULL);
+	while (1)
+	{
+		fd_set fds;
+		struct timeval tv = { 0, 200000 };
+		time_t now;
+		uint8_t ch;
+
+		FD_ZERO(&fds);
+		FD_SET(fd_in, &fds);
+		if (select(fd_in + 1, &fds, NULL, NULL, &tv) > 0)
+		{
+			if (read(fd_in, &ch, 1) != 1)
+				break;
+			if (ch == '\r')
+				continue;
+			if (ch != '\n')
+			{
+				if (line_len < (int)sizeof(line) - 1)
+					line[line_len++] = ch;
+				continue;
+			}
+			line[line_len] = '\0';
+			line_len = 0;
+			if (verbose)
+				fprintf(stderr, " < %s\n", line);
+
+			if (strcmp(line, "RTC?") == 0)
+			{
+				sendRTC();
+			}
+			else if ((strcmp(line, "N0?") == 0) || (strcmp(line, "N1?") == 0))
+			{
+				if (!queued)
+				{
+					char buf[32];
+					int n = snprintf(buf, sizeof(buf), "(%02x-0)F%02x%04x\n", addr,
+							 chunks ? (pages | OTA_DELTA) : pages, crc);
+					sendMaster(buf, n);
+					printf("update request queued\n");
+					queued = 1;
+					last_answer = time(NULL);
+				}
+			}
+			else if (strncmp(line, "OTA(", 4) == 0)
+			{
+				unsigned int a, p, b, st;
+
+				if ((sscanf(line, "OTA(%x) %2x%2x%2x", &a, &p, &b, &st) != 4) || ((int)a != addr))
+					continue;
+				last_answer = time(NULL);
+				if ((st & ~OTA_ST_DELTA) == OTA_ST_DONE)
+				{
+					printf("\ndone, image checked by bootloader\n");
+					return EXIT_SUCCESS;
+				}
+				if ((st & OTA_ST_DELTA) && !chunks)
+				{
+					fprintf(stderr, "\nbootloader expects delta, use --base\n");
+					return EXIT_FAILURE;
+				}
+				if ((st & OTA_ST_DELTA) && ((int)p >= chunks))
+				{
+					fprintf(stderr, "\nbootloader wants chunk %u, patch has %d chunks\n", p, chunks);
+					return EXIT_FAILURE;
+				}
+				if ((st & OTA_ST_DELTA) && (chunk[p] + (int)b * OTA_BLOCK >= chunk[p + 1]))
+				{
+					fprintf(stderr, "\nbootloader wants block %u of chunk %u\n", b, p);
+					return EXIT_FAILURE;
+				}
+				if (st == OTA_ST_BASE)
+					printf("\nold image does not match, full image is sent\n");
+				if (st == OTA_ST_CRC)
+				{
+					printf("\nCRC error, bootloader starts again\n");
+					if (++crc_errors >= MAX_CRC_ERRORS)
+						return EXIT_FAILURE;
+				}
+				if (!(st & OTA_ST_DELTA) && ((int)p >= pages))
+				{
+					fprintf(stderr, "\nbootloader wants page %u, image has %d pages\n", p, pages);
+					return EXIT_FAILURE;
+				}
+				if ((int)p != page)
+				{
+					if (st & OTA_ST_DELTA)
+						printf("\rchunk %d/%d ", p + 1, chunks);
+					else
+						printf("\rpage %d/%d ", p + 1, pages);
+					fflush(stdout);
+				}
+				page = p;
+				blk = b;
+				if (st & OTA_ST_DELTA)
+					block = patch + chunk[page] + blk * OTA_BLOCK;
+				else
+					block = image + page * OTA_PAGE + blk * OTA_BLOCK;
+				sendBlock(addr, page, blk, block);
+				last_send = time(NULL);
+			}
+			continue;
+		}
+
+		now = time(NULL);
+		if (now - last_answer > TIMEOUT_LINK)
+		{
+			fprintf(stderr, "\nno answer from bootloader\n");
+			return EXIT_FAILURE;
+		}
+		if (!queued)
+			continue;
+		if ((page >= 0) && (now - last_send >= RETRY_BLOCK) && (now - last_answer < RETRY_QUERY * 5))
+		{
+			sendBlock(addr, page, blk, block);
+			last_send = now;
+		}
+		else if (now - last_send >= RETRY_QUERY)
+		{
+			char buf[8];
+			int n = snprintf(buf, sizeof(buf), "Q%02x\n", addr);
+			sendMaster(buf, n);
+			last_send = now;
+		}
+	}
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,304 @@
+/*
+ *  Open HR20
+ *
+ *  target:     host side (gateway) tools
+ *
+ *  copyright:  2010 Open HR20 project
+ *
+ *  license:    This program is free software; you can redistribute it and/or
+ *              modify it under the terms of the GNU Library General Public
+ *              License as published by the Free Software Foundation; either
+ *              version 2 of the License, or (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program. If not, see http:*www.gnu.org/licenses
+ */
+
+/*!
+ * \file	motorprof.c
+ * \brief	analyzer for motor profile records of OpenHR20 (command P)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#define MAX_MOVES 4096
+
+/* must match src/motor.h */
+#define PROF_OPEN 0x01
+#define PROF_POS 1
+#define PROF_END 2
+#define PROF_ERR 3
+#define PROF_ABORT 4
+
+#define TICKS_PER_SECOND (4000000.0 / 256.0)    // timer0 overflows
+
+/*! decoded motor_profile_t */
+typedef struct
+{
+	int addr;
+	int seq;
+	int open;
+	int reason;
+	int pos_start;
+	int pos_stop;
+	int duration;           //!< unit is 256 timer0 overflows
+	int pwm_start;
+	int pwm_min;
+	int pwm_max;
+	int pwm_avg;
+	int hist[4];
+} move_t;
+
+static move_t moves[MAX_MOVES];
+static int moves_n = 0;
+
+static const char *reason_names[] = { "-", "pos", "end", "err", "abort" };
+
+/*!
+ ********************************************************************************
+ * hexByte
+ *
+ * \param *s two hex digits
+ * \returns byte value or -1
+ *******************************************************************************/
+static int hexByte(const char *s)
+{
+	char buf[3] = { s[0], s[1], 0 };
+	char *end;
+	long v;
+
+	if (!s[0] || !s[1])
+		return -1;
+	v = strtol(buf, &end, 16);
+	if (*end)
+		return -1;
+	return (int)v;
+}
+
+/*!
+ ********************************************************************************
+ * parseLine
+ *
+ * find "P[ii]=" followed by 16 bytes in hex, it accepts output of thermostat
+ * serial port, text dump of rfm-master and its copy in debug_log
+ *
+ * \param *line text line
+ * \param addr thermostat address from last "(aa){" line, -1 unknown
+ * \param *m decoded move
+ * \returns 1 if record was found
+ *******************************************************************************/
+static int parseLine(const char *line, int addr, move_t *m)
+{
+	const char *p = strstr(line, "P[");
+	uint8_t b[16];
+	int i;
+
+	if (!p || (strlen(p) < 6 + 32) || (p[4] != ']') || (p[5] != '='))
+		return 0;
+	p += 6;
+	for (i = 0; i < 16; i++)
+	{
+		int v = hexByte(p + 2 * i);
+		if (v < 0)
+			return 0;
+		b[i] = v;
+	}
+	memset(m, 0, sizeof(*m));
+	m->addr = addr;
+	m->seq = b[0];
+	m->open = (b[1] & PROF_OPEN) != 0;
+	m->reason = b[1] >> 4;
+	m->pos_start = (int16_t)(b[2] | (b[3] << 8));   // AVR is little endian
+	m->pos_stop = (int16_t)(b[4] | (b[5] << 8));
+	m->duration = b[6] | (b[7] << 8);
+	m->pwm_start = b[8];
+	m->pwm_min = b[9];
+	m->pwm_max = b[10];
+	m->pwm_avg = b[11];
+	for (i = 0; i < 4; i++)
+		m->hist[i] = b[12 + i];
+	return m->reason != 0;  // unused record
+}
+
+/*!
+ ********************************************************************************
+ * addMove
+ *
+ * ring on thermostat is read repeatedly, same move is stored only once
+ *
+ * \param *m decoded move
+ *******************************************************************************/
+static void addMove(const move_t *m)
+{
+	int i;
+
+	for (i = 0; i < moves_n; i++)
+	{
+		if ((moves[i].addr == m->addr) && (moves[i].seq == m->seq)
+		    && (moves[i].pos_start == m->pos_start) && (moves[i].duration == m->duration))
+			return;
+	}
+	if (moves_n < MAX_MOVES)
+		moves[moves_n++] = *m;
+}
+
+/*!
+ ********************************************************************************
+ * readFile
+ *
+ * \param *f input
+ *******************************************************************************/
+static void readFile(FILE *f)
+{
+	char line[512];
+	int addr = -1;
+	move_t m;
+
+	while (fgets(line, sizeof(line), f))
+	{
+		unsigned int a;
+		if (sscanf(line, "(%2x){", &a) == 1)
+			addr = a;
+		else if (line[0] == '}')
+			addr = -1;
+		if (parseLine(line, addr, &m))
+			addMove(&m);
+	}
+}
+
+/*!
+ ********************************************************************************
+ * printMoves
+ *******************************************************************************/
+static void printMoves(void)
+{
+	int i;
+
+	printf("addr seq dir reason  start  stop pulses   time  p/s  pwm:st min avg max  hist%%: <3/4 <1 <5/4 slow\n");
+	for (i = 0; i < moves_n; i++)
+	{
+		const move_t *m = &moves[i];
+		int pulses = abs(m->pos_stop - m->pos_start);
+		double t = m->duration * 256 / TICKS_PER_SECOND;
+		int hsum = m->hist[0] + m->hist[1] + m->hist[2] + m->hist[3];
+		int h;
+
+		printf("%4d %3d %-5s %-6s %5d %5d %6d %6.2f %4.1f     %3d %3d %3d %3d       ",
+		       m->addr, m->seq, m->open ? "open" : "close",
+		       reason_names[(m->reason <= PROF_ABORT) ? m->reason : 0],
+		       m->pos_start, m->pos_stop, pulses, t, (t > 0) ? pulses / t : 0.0,
+		       m->pwm_start, m->pwm_min, m->pwm_avg, m->pwm_max);
+		for (h = 0; h < 4; h++)
+			printf(" %4d", hsum ? (m->hist[h] * 100 + hsum / 2) / hsum : 0);
+		printf("\n");
+	}
+}
+
+/*!
+ ********************************************************************************
+ * printSummary
+ *
+ * pwm_min of moves which reached wanted position without slow pulses shows
+ * how low motor_pwm_min can be
+ *
+ * \param slow_limit maximal share of slow pulses in % for healthy move
+ *******************************************************************************/
+static void printSummary(int slow_limit)
+{
+	int dir;
+
+	for (dir = 0; dir <= 1; dir++)
+	{
+		int n = 0, ok = 0, ends = 0, errs = 0, lowest = 256;
+		long avg_sum = 0, pulses = 0;
+		double time = 0;
+		int i;
+
+		for (i = 0; i < moves_n; i++)
+		{
+			const move_t *m = &moves[i];
+			int hsum = m->hist[0] + m->hist[1] + m->hist[2] + m->hist[3];
+			if (m->open != dir)
+				continue;
+			n++;
+			pulses += abs(m->pos_stop - m->pos_start);
+			time += m->duration * 256 / TICKS_PER_SECOND;
+			if (m->reason == PROF_END)
+				ends++;
+			if ((m->reason == PROF_ERR) || (m->reason == PROF_ABORT))
+				errs++;
+			if ((m->reason == PROF_POS) && hsum && (m->hist[3] * 100 <= slow_limit * hsum))
+			{
+				ok++;
+				avg_sum += m->pwm_avg;
+				if (m->pwm_min < lowest)
+					lowest = m->pwm_min;
+			}
+		}
+		if (n == 0)
+			continue;
+		printf("\n%s: %d moves, %ld pulses, %.1f s motor time", dir ? "open" : "close", n, pulses, time);
+		printf(", %d end stops, %d errors\n", ends, errs);
+		if (ok)
+			printf("  %d healthy moves: average PWM %ld, lowest PWM %d (motor_pwm_min candidate)\n",
+			       ok, avg_sum / ok, lowest);
+		else
+			printf("  no healthy move (wanted position reached, slow pulses <= %d%%)\n", slow_limit);
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-l slow_limit] [file ...]\n", name);
+	fprintf(stderr, "  reads P[ii]=... lines from thermostat or rfm-master output\n");
+	fprintf(stderr, "  -l  maximal share of slow pulses in healthy move, default 10 (%%)\n");
+}
+
+int main(int argc, char **argv)
+{
+	int slow_limit = 10;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'l':
+			slow_limit = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc)
+		readFile(stdin);
+	for (; optind < argc; optind++)
+	{
+		FILE *f = fopen(argv[optind], "r");
+		if (!f)
+		{
+			perror(argv[optind]);
+			return 1;
+		}
+		readFile(f);
+		fclose(f);
+	}
+	if (moves_n == 0)
+	{
+		fprintf(stderr, "no motor profile records found\n");
+		return 1;
+	}
+	printMoves();
+	printSummary(slow_limit);
+	return 0;
+}